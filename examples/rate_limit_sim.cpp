@@ -0,0 +1,61 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "rate_limit_simulator.h"
+
+using namespace nexusmods;
+
+// Compares the built-in pacing policies on a synthetic workload (or a
+// recorded one given as a CSV path, see load_workload).
+int main(int argc, char **argv) {
+  using namespace std::chrono;
+
+  std::vector<SimRequest> workload =
+      argc > 1 ? load_workload(argv[1])
+               : synthetic_workload(/*interactive_per_hour=*/200,
+                                    /*bulk_per_hour=*/0,
+                                    /*bulk_batch=*/25000, hours(24 * 60));
+  if (workload.empty()) {
+    std::cerr << "Usage: rate_limit_sim [workload.csv]\n";
+    return 1;
+  }
+
+  auto even = std::make_shared<EvenPacing>();
+  auto burst = std::make_shared<BurstPacing>();
+  struct Named {
+    const char *name;
+    std::shared_ptr<PacingPolicy> policy;
+    bool admission = false;
+  } policies[] = {
+      {"none", nullptr},
+      {"burst", burst},
+      {"even", even},
+      {"priority 20%/even", std::make_shared<PriorityPacing>(0.2, even, burst)},
+      {"burst+admission", burst, true},
+  };
+
+  std::cout << workload.size() << " requests\n\n"
+            << std::left << std::setw(20) << "policy" << std::right
+            << std::setw(10) << "429s" << std::setw(12) << "done/h"
+            << std::setw(14) << "int p50 ms" << std::setw(14) << "int p99 ms"
+            << std::setw(14) << "bulk p50 s" << std::setw(14) << "bulk p99 s"
+            << std::setw(12) << "unfinished" << std::setw(10) << "wall ms"
+            << "\n";
+  for (const auto &p : policies) {
+    auto start = steady_clock::now();
+    SimOptions options;
+    options.admission = p.admission;
+    SimReport r = simulate_rate_limits(workload, p.policy, options);
+    auto wall = duration_cast<milliseconds>(steady_clock::now() - start);
+    std::cout << std::left << std::setw(20) << p.name << std::right
+              << std::setw(10) << r.rejected << std::setw(12) << std::fixed
+              << std::setprecision(1) << r.completed_per_hour << std::setw(14)
+              << r.interactive.p50.count() << std::setw(14)
+              << r.interactive.p99.count() << std::setw(14)
+              << duration_cast<seconds>(r.bulk.p50).count() << std::setw(14)
+              << duration_cast<seconds>(r.bulk.p99).count() << std::setw(12)
+              << r.unfinished << std::setw(10) << wall.count() << "\n";
+  }
+  return 0;
+}
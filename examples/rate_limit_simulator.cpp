@@ -0,0 +1,260 @@
+#include "rate_limit_simulator.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <optional>
+#include <queue>
+#include <random>
+
+namespace nexusmods {
+
+namespace {
+
+using std::chrono::milliseconds;
+using TimePoint = RateLimitState::TimePoint;
+
+constexpr milliseconds kHour = std::chrono::hours(1);
+constexpr milliseconds kDay = std::chrono::hours(24);
+constexpr milliseconds kNever = milliseconds::max();
+
+// Quota bookkeeping as the API does it: every request counts against both
+// quotas, and one is allowed while either has requests left.
+struct Server {
+  int64_t hourly_limit;
+  int64_t daily_limit;
+  int64_t hourly_used = 0;
+  int64_t daily_used = 0;
+  int64_t hour = -1;
+  int64_t day = -1;
+
+  bool handle(milliseconds t, RateLimitState &report) {
+    if (t / kHour != hour) {
+      hour = t / kHour;
+      hourly_used = 0;
+    }
+    if (t / kDay != day) {
+      day = t / kDay;
+      daily_used = 0;
+    }
+    bool ok = hourly_used < hourly_limit || daily_used < daily_limit;
+    if (ok) {
+      ++hourly_used;
+      ++daily_used;
+    }
+    report.known = true;
+    report.hourly_limit = hourly_limit;
+    report.hourly_remaining = std::max<int64_t>(hourly_limit - hourly_used, 0);
+    report.hourly_reset = TimePoint((hour + 1) * kHour);
+    report.daily_limit = daily_limit;
+    report.daily_remaining = std::max<int64_t>(daily_limit - daily_used, 0);
+    report.daily_reset = TimePoint((day + 1) * kDay);
+    return ok;
+  }
+};
+
+enum class EventType : uint8_t { Response, Wake };
+
+struct Event {
+  milliseconds t;
+  uint64_t seq;
+  EventType type;
+  uint32_t request;
+  bool ok;
+
+  bool operator>(const Event &o) const {
+    return t != o.t ? t > o.t : seq > o.seq;
+  }
+};
+
+SimReport::Latency summarize(std::vector<milliseconds> &v) {
+  SimReport::Latency out;
+  out.completed = v.size();
+  if (v.empty())
+    return out;
+  std::sort(v.begin(), v.end());
+  auto at = [&](double q) {
+    return v[std::min(v.size() - 1, static_cast<size_t>(q * double(v.size())))];
+  };
+  out.p50 = at(0.50);
+  out.p95 = at(0.95);
+  out.p99 = at(0.99);
+  out.max = v.back();
+  return out;
+}
+
+} // namespace
+
+SimReport simulate_rate_limits(const std::vector<SimRequest> &workload,
+                               std::shared_ptr<PacingPolicy> policy,
+                               const SimOptions &options) {
+  milliseconds now{0};
+  RateLimitBudget budget(std::move(policy), [&] { return TimePoint(now); });
+  Server server{options.hourly_limit, options.daily_limit};
+  const milliseconds horizon = options.horizon;
+  const size_t concurrency = std::max<size_t>(options.concurrency, 1);
+
+  std::vector<RateLimitState> reports(workload.size());
+  std::vector<bool> was_deferred(workload.size()); // counted in `deferred`
+  std::deque<uint32_t> queues[2]; // by Priority
+  std::priority_queue<Event, std::vector<Event>, std::greater<>> events;
+  std::vector<milliseconds> latency[2];
+  uint64_t seq = 0;
+  size_t next_arrival = 0;
+  size_t in_flight = 0;
+  milliseconds wake_at = kNever; // earliest Wake event pending
+  SimReport report;
+
+  auto send = [&](uint32_t id) {
+    budget.on_sent(workload[id].priority);
+    bool ok = server.handle(now, reports[id]);
+    ++report.sent;
+    ++in_flight;
+    events.push({now + options.latency, seq++, EventType::Response, id, ok});
+  };
+
+  // Fill free slots, Interactive first. A priority the policy holds back
+  // doesn't block the other; if both wait, wake up when the first may go.
+  auto dispatch = [&] {
+    while (in_flight < concurrency) {
+      std::optional<milliseconds> wait;
+      bool sent = false;
+      for (int p = 0; p < 2 && !sent; ++p) {
+        if (queues[p].empty())
+          continue;
+        auto priority = static_cast<Priority>(p);
+        milliseconds d = budget.delay(priority);
+        if (d.count() == 0 && options.admission &&
+            priority == Priority::Bulk && !budget.may_spend(1, priority)) {
+          // The same request is refused again on every re-check until it
+          // may go; count it once.
+          if (!was_deferred[queues[p].front()]) {
+            was_deferred[queues[p].front()] = true;
+            ++report.deferred;
+          }
+          d = options.admission_retry;
+        }
+        if (d.count() > 0) {
+          wait = wait ? std::min(*wait, d) : d;
+          continue;
+        }
+        uint32_t id = queues[p].front();
+        queues[p].pop_front();
+        send(id);
+        sent = true;
+      }
+      if (sent)
+        continue;
+      if (wait && now + *wait < wake_at) {
+        wake_at = now + *wait;
+        events.push({wake_at, seq++, EventType::Wake, 0, false});
+      }
+      return;
+    }
+  };
+
+  for (;;) {
+    bool arrival = next_arrival < workload.size() &&
+                   (events.empty() ||
+                    workload[next_arrival].arrival <= events.top().t);
+    if (!arrival && events.empty())
+      break;
+    milliseconds t = arrival ? workload[next_arrival].arrival : events.top().t;
+    if (t > horizon)
+      break;
+    now = std::max(now, t);
+
+    if (arrival) {
+      const SimRequest &r = workload[next_arrival];
+      queues[static_cast<int>(r.priority)].push_back(
+          static_cast<uint32_t>(next_arrival));
+      ++next_arrival;
+    } else {
+      Event e = events.top();
+      events.pop();
+      if (e.type == EventType::Wake) {
+        if (wake_at <= now)
+          wake_at = kNever;
+      } else {
+        --in_flight;
+        budget.observe(reports[e.request]);
+        const SimRequest &r = workload[e.request];
+        int p = static_cast<int>(r.priority);
+        if (e.ok) {
+          latency[p].push_back(now - r.arrival);
+        } else {
+          ++report.rejected;
+          queues[p].push_front(e.request);
+        }
+      }
+    }
+    dispatch();
+  }
+
+  report.interactive = summarize(latency[0]);
+  report.bulk = summarize(latency[1]);
+  report.unfinished = workload.size() - report.interactive.completed -
+                      report.bulk.completed;
+  report.simulated = now;
+  double hours = std::max(1.0, double(now.count()) / double(kHour.count()));
+  report.completed_per_hour =
+      double(report.interactive.completed + report.bulk.completed) / hours;
+  return report;
+}
+
+std::vector<SimRequest> synthetic_workload(double interactive_per_hour,
+                                           double bulk_per_hour,
+                                           size_t bulk_batch,
+                                           std::chrono::hours hours,
+                                           uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  const double end = double(milliseconds(hours).count());
+  std::vector<SimRequest> out;
+
+  auto poisson = [&](double per_hour, Priority priority) {
+    if (per_hour <= 0)
+      return;
+    std::exponential_distribution<double> gap(per_hour /
+                                              double(kHour.count()));
+    for (double t = gap(rng); t < end; t += gap(rng))
+      out.push_back({milliseconds(static_cast<int64_t>(t)), priority});
+  };
+  poisson(interactive_per_hour, Priority::Interactive);
+  poisson(bulk_per_hour, Priority::Bulk);
+  for (milliseconds day{0}; day.count() < end; day += kDay)
+    for (size_t i = 0; i < bulk_batch; ++i)
+      out.push_back({day, Priority::Bulk});
+
+  std::stable_sort(out.begin(), out.end(),
+                   [](const SimRequest &a, const SimRequest &b) {
+                     return a.arrival < b.arrival;
+                   });
+  return out;
+}
+
+std::vector<SimRequest> load_workload(const std::string &csv_path) {
+  std::vector<SimRequest> out;
+  std::ifstream in(csv_path);
+  std::string line;
+  while (std::getline(in, line)) {
+    auto comma = line.find(',');
+    if (comma == std::string::npos || comma + 1 >= line.size())
+      continue;
+    try {
+      int64_t ms = std::stoll(line.substr(0, comma));
+      char kind = line[comma + 1];
+      if (kind != 'i' && kind != 'b')
+        continue;
+      out.push_back({milliseconds(ms),
+                     kind == 'i' ? Priority::Interactive : Priority::Bulk});
+    } catch (...) {
+    }
+  }
+  std::stable_sort(out.begin(), out.end(),
+                   [](const SimRequest &a, const SimRequest &b) {
+                     return a.arrival < b.arrival;
+                   });
+  return out;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nexusmods/rate_limit.h"
+
+namespace nexusmods {
+
+// Discrete-event simulation of a client working through a request workload
+// against the API's quotas, used to compare pacing policies offline. The
+// simulated server keeps hourly and daily counters that reset on the hour
+// and at midnight UTC, and answers 429 once both are spent. The client side
+// is a real RateLimitBudget on a simulated clock, so what is measured is the
+// library's own pacing code.
+
+struct SimRequest {
+  std::chrono::milliseconds arrival{0}; // since the start of the simulation
+  Priority priority = Priority::Interactive;
+};
+
+struct SimOptions {
+  int64_t hourly_limit = 500;
+  int64_t daily_limit = 20000;
+  std::chrono::milliseconds latency{200}; // request to response
+  size_t concurrency = 4;                 // requests in flight at once
+  // Gate Bulk requests on RateLimitBudget::may_spend as well as the policy,
+  // asking again every `admission_retry` while refused.
+  bool admission = false;
+  std::chrono::milliseconds admission_retry{std::chrono::minutes(1)};
+  // Stop even if requests are still queued.
+  std::chrono::hours horizon{24 * 365};
+};
+
+struct SimReport {
+  struct Latency {
+    uint64_t completed = 0;
+    std::chrono::milliseconds p50{0}, p95{0}, p99{0}, max{0};
+  };
+
+  Latency interactive;
+  Latency bulk;
+  uint64_t sent = 0;
+  uint64_t rejected = 0;   // 429 answers, each retried
+  uint64_t deferred = 0;   // Bulk requests refused admission at least once
+  uint64_t unfinished = 0; // still queued at the horizon
+  std::chrono::milliseconds simulated{0};
+  double completed_per_hour = 0;
+};
+
+SimReport simulate_rate_limits(const std::vector<SimRequest> &workload,
+                               std::shared_ptr<PacingPolicy> policy,
+                               const SimOptions &options = SimOptions());
+
+// Poisson arrivals at the given hourly rates for `hours`, plus a bulk batch
+// of `bulk_batch` requests arriving together at the start of every day.
+std::vector<SimRequest> synthetic_workload(double interactive_per_hour,
+                                           double bulk_per_hour,
+                                           size_t bulk_batch,
+                                           std::chrono::hours hours,
+                                           uint64_t seed = 1);
+
+// Recorded workload, one request per line: "<arrival_ms>,<i|b>". Lines that
+// don't parse are skipped. Sorted by arrival.
+std::vector<SimRequest> load_workload(const std::string &csv_path);
+
+} // namespace nexusmods
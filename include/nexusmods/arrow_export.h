@@ -0,0 +1,54 @@
+#pragma once
+
+// Only available when the library is configured with
+// -DNEXUSMODS_WITH_ARROW=ON (requires Apache Arrow and Parquet >= 12).
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "nexusmods/types.h"
+
+namespace nexusmods {
+
+// Streams typed catalog records into a columnar file. Rows are buffered in
+// Arrow builders and written as one record batch (Parquet: one row group)
+// every `batch_rows` rows, so memory stays flat however large the catalog.
+//
+//   CatalogExporter out;
+//   out.open("mods.arrow", CatalogExporter::Table::Mods);
+//   for (...) out.append(*Mod::from_json(*client.get_mod(game, id)));
+//   out.close();
+class CatalogExporter {
+public:
+  enum class Format { ArrowIpc, Parquet };
+  enum class Table { Mods, Files };
+
+  struct Options {
+    Format format = Format::ArrowIpc;
+    size_t batch_rows = 64 * 1024;
+  };
+
+  CatalogExporter();
+  ~CatalogExporter(); // closes the file if still open
+
+  CatalogExporter(const CatalogExporter &) = delete;
+  CatalogExporter &operator=(const CatalogExporter &) = delete;
+
+  // All calls return false on failure; last_error() says why.
+  bool open(const std::string &path, Table table);
+  bool open(const std::string &path, Table table, Options options);
+  bool append(const Mod &mod);      // Table::Mods only
+  bool append(const ModFile &file); // Table::Files only
+  // Write the pending batch and finalize the file footer.
+  bool close();
+
+  size_t rows_written() const;
+  const std::string &last_error() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace nexusmods
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace nexusmods {
+
+class TlsContext;
+
+// Bounding box for a thumbnail; the resizer keeps the aspect ratio.
+struct ThumbnailSize {
+  int width = 0;
+  int height = 0;
+};
+
+// Scales an encoded image to fit `size` and returns it encoded again, or
+// nullopt if it can't. The library doesn't decode images itself.
+using ImageResizer = std::function<std::optional<std::string>(
+    std::string_view image, ThumbnailSize size)>;
+
+struct Asset {
+  enum class Source : uint8_t {
+    Cache,       // fresh copy on disk, no request made
+    Revalidated, // server answered 304 Not Modified
+    Downloaded,
+    Stale, // the request failed; the last copy on disk is served
+  };
+
+  std::string path;         // file in the cache directory
+  std::string content_type; // as served; thumbnails keep the original's
+  Source source = Source::Cache;
+  // The image itself, instead of `path`, when the server forbade storing it
+  // (Cache-Control: no-store). Such responses never touch the disk.
+  std::string data;
+};
+
+// Downloads images such as Mod::picture_url into a disk cache, several at
+// once, so a list of mods can be rendered from local files. Only https URLs
+// are fetched, and only redirects to https URLs are followed.
+//
+// The cache is content-addressed. Bodies are stored under the SHA-256 of
+// their bytes, so a picture served from several URLs is kept once.
+// Thumbnails are keyed by that hash and their size. Each URL has a small
+// index entry holding its content hash, validators and expiry. A copy
+// younger than its Cache-Control max-age (or `max_age` without one) is used
+// as is. An older one is revalidated with If-None-Match / If-Modified-Since.
+// Concurrent fetches of the same URL share one download.
+//
+// Files are written to a temporary name and renamed into place, so several
+// fetchers, in one process or several, can share a directory.
+class AssetFetcher {
+public:
+  struct Options {
+    std::string cache_dir;
+    size_t max_parallel = 8; // downloads in flight
+    std::chrono::seconds max_age{std::chrono::hours(24)};
+    std::chrono::seconds timeout{30};
+    std::string user_agent = "nexusmods-cpp/1.0";
+    std::shared_ptr<TlsContext> tls; // null: httplib's default CAs
+    // Needed for thumbnails; without it they are served at full size.
+    // Thumbnails are kept across runs, so clear thumbs/ in the cache
+    // directory when changing it.
+    ImageResizer resizer;
+  };
+
+  struct Stats {
+    uint64_t hits = 0; // Source::Cache
+    uint64_t revalidated = 0;
+    uint64_t downloaded = 0;
+    uint64_t stale = 0;
+    uint64_t failed = 0;
+    uint64_t shared = 0; // joined a fetch already under way
+    uint64_t resized = 0;
+  };
+
+  explicit AssetFetcher(Options options);
+  // Finishes queued fetches, then stops the workers.
+  ~AssetFetcher();
+
+  AssetFetcher(const AssetFetcher &) = delete;
+  AssetFetcher &operator=(const AssetFetcher &) = delete;
+
+  // nullopt if the asset could not be fetched and isn't cached. Exceptions
+  // (e.g. from the resizer) reach every caller sharing the fetch.
+  std::future<std::optional<Asset>> fetch_async(const std::string &url);
+  std::future<std::optional<Asset>> fetch_async(const std::string &url,
+                                                ThumbnailSize size);
+  std::optional<Asset> fetch(const std::string &url);
+  std::optional<Asset> fetch(const std::string &url, ThumbnailSize size);
+
+  // Deletes the least recently used bodies and thumbnails until the cache
+  // holds at most `max_bytes` of them. Returns the bytes freed.
+  uint64_t prune(uint64_t max_bytes);
+
+  Stats stats() const;
+
+private:
+  struct Key {
+    std::string url;
+    int width = 0; // 0: the original
+    int height = 0;
+    bool operator<(const Key &o) const;
+  };
+  using Promise = std::promise<std::optional<Asset>>;
+  class Connections; // one worker's clients, by host
+
+  void work();
+  std::optional<Asset> load(const Key &key, Connections &connections);
+  std::optional<Asset> thumbnail(Asset original, ThumbnailSize size);
+
+  const Options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<Key, std::vector<Promise>> pending_; // queued or in flight
+  std::deque<Key> jobs_;                        // queued
+  bool stop_ = false;
+  Stats stats_;
+
+  std::vector<std::thread> workers_;
+};
+
+} // namespace nexusmods
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "nexusmods/memory_accountant.h"
+
+namespace nexusmods {
+
+// Recycles response body strings. Buffers are kept in power-of-two size
+// classes (4 KiB - 16 MiB) keyed by their capacity, so a request whose
+// Content-Length is known gets a buffer that never reallocates while the
+// body streams in. Thread-safe; can be shared between clients.
+class BufferPool {
+public:
+  struct Stats {
+    size_t hits = 0;   // acquire() served from the pool
+    size_t misses = 0; // acquire() had to allocate
+    size_t pooled_buffers = 0;
+    size_t pooled_bytes = 0;
+  };
+
+  // `max_pooled_bytes` caps idle memory held by the pool. With an
+  // accountant, idle buffers are also charged to it and dropped when it
+  // asks for memory back.
+  explicit BufferPool(size_t max_pooled_bytes = 64u << 20,
+                      std::shared_ptr<MemoryAccountant> accountant = nullptr);
+  ~BufferPool();
+
+  BufferPool(const BufferPool &) = delete;
+  BufferPool &operator=(const BufferPool &) = delete;
+
+  // Empty string with capacity for at least `size_hint` bytes.
+  std::string acquire(size_t size_hint);
+
+  // Hand a buffer back. Buffers outside the size classes, or beyond the
+  // pool's limits, are simply freed.
+  void release(std::string &&buffer);
+
+  // Free idle buffers, largest first, until `bytes` have been dropped.
+  void trim(size_t bytes = static_cast<size_t>(-1));
+
+  Stats stats() const;
+
+private:
+  struct Impl;
+  std::shared_ptr<Impl> impl_;
+};
+
+} // namespace nexusmods
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nexusmods {
+
+// Cumulative resource usage of the calling thread.
+struct ThreadUsage {
+  int64_t cpu_ns = 0; // CLOCK_THREAD_CPUTIME_ID
+  // Heap allocations made by this thread; zero unless the library was built
+  // with -DNEXUSMODS_WITH_ALLOC_HOOKS=ON, which replaces operator new.
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+
+  static ThreadUsage now();
+  static bool tracks_allocations();
+};
+
+// Per-endpoint cost of Client calls, split into phases. Endpoints are
+// normalized so calls for different mods share a row:
+//   /v1/games/skyrim/mods/123/files.json -> /v1/games/{game}/mods/{id}/files.json
+class CallMetrics {
+public:
+  enum class Phase : uint8_t {
+    Headers,   // building the request headers
+    Transport, // every attempt on the transport, body included; not backoff
+    Parse,     // JSON decoding, on whichever thread did it
+  };
+  static constexpr size_t kPhases = 3;
+
+  struct Cost {
+    uint64_t samples = 0;
+    int64_t wall_ns = 0;
+    int64_t cpu_ns = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+  };
+
+  struct Endpoint {
+    std::string endpoint;
+    uint64_t calls = 0;
+    std::array<Cost, kPhases> phases{};
+  };
+
+  // Measures one phase from construction to destruction (or finish()).
+  class Scope {
+  public:
+    Scope(CallMetrics *metrics, std::string_view path, Phase phase);
+    ~Scope() { finish(); }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+    void finish();
+
+  private:
+    CallMetrics *metrics_;
+    std::string_view path_;
+    Phase phase_;
+    std::chrono::steady_clock::time_point wall_;
+    ThreadUsage start_;
+  };
+
+  void add(std::string_view path, Phase phase, const Cost &cost);
+  void count_call(std::string_view path);
+
+  // Most expensive first, by total CPU over all phases.
+  std::vector<Endpoint> snapshot() const;
+  void reset();
+
+  static std::string normalize(std::string_view path);
+
+private:
+  Endpoint &row_locked(std::string_view path);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Endpoint, std::less<>> rows_;
+};
+
+const char *to_string(CallMetrics::Phase phase);
+
+} // namespace nexusmods
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "nexusmods/change_log.h"
+
+namespace nexusmods {
+
+class Client;
+
+// Incremental catalog sync for one or more games. Each run asks
+// get_updated_mods() what moved within `period`, compares that with the
+// activity timestamps seen on earlier runs and fetches only the mods (and
+// file lists) that actually changed, appending one ChangeRecord per changed
+// object to the log. Downstream consumers tail the log instead of diffing
+// dumps.
+//
+// What each game's runs have seen is saved next to the log segments, as
+// sync-<game>.state, once the run's records are flushed, so a restarted
+// process picks up where it left off. Records appended after the last save
+// may be emitted again after a crash.
+//
+//   ChangeLog log;
+//   log.open("/var/lib/nexus/changes");
+//   CatalogSync sync(client, log);
+//   sync.run("skyrimspecialedition", "1d"); // e.g. hourly
+class CatalogSync {
+public:
+  struct RunStats {
+    bool ok = false;       // false if the updated-mods listing failed
+    size_t candidates = 0; // entries in the updated-mods listing
+    size_t mods_changed = 0;
+    size_t files_changed = 0;
+    size_t fetch_failures = 0; // mods skipped; retried on the next run
+  };
+
+  CatalogSync(Client &client, ChangeLog &log);
+
+  // `period` is passed to get_updated_mods ("1d", "1w" or "1m") and should
+  // cover the time since the previous run.
+  RunStats run(const std::string &game_domain_name,
+               const std::string &period = "1d");
+
+  // Forget what earlier runs saw, saved state included, so the next run
+  // re-emits every mod in its window.
+  void reset();
+
+private:
+  // Upstream timestamps already in the log for one mod.
+  struct Seen {
+    int64_t mod_activity = 0;
+    int64_t file_update = 0;
+    int64_t game_id = 0; // from the last mod record, for file records
+  };
+  using GameState = std::unordered_map<int64_t, Seen>; // by mod id
+
+  GameState &state_for(const std::string &game_domain_name);
+  void save(const std::string &game_domain_name, const GameState &state);
+
+  Client &client_;
+  ChangeLog &log_;
+  std::mutex mutex_; // one run at a time
+  std::unordered_map<std::string, GameState> seen_; // by game domain
+  std::unordered_set<std::string> loaded_; // games read back from disk
+};
+
+} // namespace nexusmods
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace nexusmods {
+
+struct ChangeRecord {
+  enum class Kind : uint8_t { ModUpdated = 1, FileUpdated = 2 };
+
+  uint64_t offset = 0; // position of this record in the log
+  Kind kind = Kind::ModUpdated;
+  int64_t game_id = 0;
+  int64_t mod_id = 0;
+  int64_t file_id = 0;   // 0 for ModUpdated
+  int64_t timestamp = 0; // unix seconds of the change upstream
+  std::string payload;   // JSON of the changed object
+};
+
+// Append-only change log split into segment files named after the log
+// offset they start at. Each record is framed as
+//
+//   u32 body length | u32 CRC-32 of body | body
+//
+// and a record's offset is its byte position in the concatenated log, so a
+// consumer's cursor is a single integer. A torn record left at the tail by a
+// crash is truncated when the log is reopened.
+class ChangeLog {
+public:
+  ChangeLog() = default;
+  ~ChangeLog();
+
+  ChangeLog(const ChangeLog &) = delete;
+  ChangeLog &operator=(const ChangeLog &) = delete;
+
+  // Opens (creating if needed) the log in `directory`. Segments roll once
+  // they exceed `segment_bytes`. False if the directory can't be used.
+  bool open(const std::string &directory, size_t segment_bytes = 64 << 20);
+
+  // Returns the record's offset, or nullopt on a write error (or if the log
+  // isn't open). `offset` in `record` is ignored.
+  std::optional<uint64_t> append(const ChangeRecord &record);
+
+  // fdatasync the active segment.
+  bool flush();
+
+  // Offset the next record will get.
+  uint64_t end_offset() const;
+
+  // Directory given to open(); empty while the log isn't open.
+  std::string directory() const;
+
+private:
+  bool open_segment_locked(uint64_t base);
+
+  std::string directory_;
+  size_t segment_bytes_ = 0;
+  mutable std::mutex mutex_;
+  int fd_ = -1;
+  uint64_t segment_base_ = 0;
+  uint64_t end_ = 0;
+};
+
+// Reads a ChangeLog from a cursor, following it as it grows. Segments are
+// memory-mapped and records decoded straight from the mapping. A reader is
+// meant for one thread; any number of readers may tail the same log.
+class ChangeLogReader {
+public:
+  explicit ChangeLogReader(std::string directory, uint64_t cursor = 0);
+  ~ChangeLogReader();
+
+  ChangeLogReader(const ChangeLogReader &) = delete;
+  ChangeLogReader &operator=(const ChangeLogReader &) = delete;
+
+  // Next complete record at or after the cursor, advancing past it.
+  // nullopt when caught up (call again later) or when the log is corrupt.
+  std::optional<ChangeRecord> next();
+
+  // Offset of the next record to read; persist it to resume later.
+  uint64_t cursor() const { return cursor_; }
+
+  // Set once a record fails its CRC; the reader stops there.
+  bool corrupt() const { return corrupt_; }
+
+private:
+  bool map_segment_for(uint64_t offset);
+  void unmap();
+
+  std::string directory_;
+  uint64_t cursor_;
+  bool corrupt_ = false;
+
+  int fd_ = -1;
+  uint64_t base_ = 0;
+  const unsigned char *data_ = nullptr;
+  size_t mapped_ = 0;
+};
+
+// CRC-32 (IEEE 802.3), as used for change log records.
+uint32_t crc32(std::string_view data);
+
+} // namespace nexusmods
@@ -1,12 +1,29 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "httplib.h"
+#include "nexusmods/buffer_pool.h"
+#include "nexusmods/call_metrics.h"
+#include "nexusmods/client_config.h"
+#include "nexusmods/lazy_document.h"
+#include "nexusmods/logger.h"
+#include "nexusmods/memory_accountant.h"
+#include "nexusmods/parse_pool.h"
+#include "nexusmods/projection.h"
+#include "nexusmods/rate_limit.h"
+#include "nexusmods/request_registry.h"
+#include "nexusmods/transport.h"
+#include "nexusmods/types.h"
 #include "rapidjson/document.h"
 
 namespace nexusmods {
@@ -17,6 +34,13 @@ struct NexusResponse {
   httplib::Headers headers;
 };
 
+// Everything the client's optional components measure, gathered at once.
+struct ClientMetrics {
+  std::vector<CallMetrics::Endpoint> endpoints; // empty without CallMetrics
+  std::optional<MemoryAccountant::Snapshot> memory;
+  std::optional<BufferPool::Stats> buffers;
+};
+
 class Client {
 public:
   // v1 enpoint: api.nexusmods.com
@@ -26,8 +50,33 @@ public:
          const std::string &host = "api.nexusmods.com", int port = 443,
          const std::string &user_agent = "nexusmods-cpp/1.0");
 
+  // Shuts down with a 5 s deadline, then waits for every call to return,
+  // cancelling through the transport again every second.
   ~Client();
 
+  // Stop accepting requests (they fail like a transport error), wake calls
+  // sleeping in backoff so they give up, and wait up to `deadline` for the
+  // rest to finish. Past the deadline, requests still on the wire are
+  // cancelled through the transport. Once no call is left the shutdown hooks
+  // run and the logger is flushed: here, or if some call outlasted the
+  // cancel, on the thread of the last call to return. Returns true if
+  // everything finished within the deadline without being cancelled. The
+  // hooks run once, for the first call.
+  bool shutdown(std::chrono::milliseconds deadline);
+
+  // Run once requests have drained after shutdown(), e.g. to flush a
+  // ChangeLog or commit a SqliteSink.
+  void add_shutdown_hook(std::function<void()> hook);
+
+  // Current settings. Requests already running keep the snapshot they
+  // started with.
+  std::shared_ptr<const ClientConfig> config() const;
+
+  // Publish new settings; the timeout is applied to the transport as well.
+  void set_config(ClientConfig config);
+  // Copy the current settings, let `edit` change them, publish the result.
+  void update_config(const std::function<void(ClientConfig &)> &edit);
+
   // Set custom header name if needed (default "apikey")
   void set_api_header_name(const std::string &header_name);
 
@@ -47,6 +96,78 @@ public:
            const httplib::Params &params = httplib::Params(),
            const httplib::Headers &extra_headers = httplib::Headers());
 
+  // Like get_json, but only the fields selected by `projection` are decoded
+  // into the returned Document. Error documents are returned unprojected.
+  std::optional<rapidjson::Document>
+  get_json_projected(const std::string &path,
+                     const FieldProjection &projection,
+                     const httplib::Params &params = httplib::Params(),
+                     const httplib::Headers &extra_headers = httplib::Headers());
+
+  // Returns the raw body with a structural index; values are decoded only
+  // when accessed. Failures are reported as the same error documents that
+  // get_json returns.
+  std::optional<LazyDocument>
+  get_json_lazy(const std::string &path,
+                const httplib::Params &params = httplib::Params(),
+                const httplib::Headers &extra_headers = httplib::Headers());
+
+  // Performs the request on the calling thread, then hands the body to the
+  // parse pool (see set_parse_pool) and returns without waiting for the
+  // decode. Without a pool, or when its queue is full, parsing happens inline
+  // and the returned future is already ready.
+  std::future<std::optional<rapidjson::Document>>
+  get_json_async(const std::string &path,
+                 const httplib::Params &params = httplib::Params(),
+                 const httplib::Headers &extra_headers = httplib::Headers());
+
+  // CPU pool used by get_json_async. May be shared between clients; pass
+  // nullptr to parse on the request thread again.
+  void set_parse_pool(std::shared_ptr<ParsePool> pool);
+
+  // Charge response bodies to `accountant` while they are decoded, and hold
+  // new requests back (up to the request timeout) while it is over its cap.
+  // Requests that can't be admitted fail like a transport error.
+  void set_memory_accountant(std::shared_ptr<MemoryAccountant> accountant);
+
+  // Draw response bodies from `pool` (sized from Content-Length) and return
+  // them once decoded. Pass nullptr to allocate per response again.
+  void set_buffer_pool(std::shared_ptr<BufferPool> pool);
+
+  // Give the body of a response obtained from get() back to the buffer pool.
+  void recycle(NexusResponse &&response);
+
+  // Replace the transport requests go out on (default: HttplibTransport to
+  // the host given to the constructor). The client's timeout is applied to
+  // it. Requests already in flight finish on the old transport.
+  void set_transport(std::shared_ptr<Transport> transport);
+
+  // Record request start/finish, retries and backoff sleeps to `logger`.
+  // May be shared between clients; nullptr turns logging off.
+  void set_logger(std::shared_ptr<Logger> logger);
+
+  // Register every request with `registry` while it runs, so its state
+  // (waiting for memory, in transport, reading the body, backing off) can be
+  // inspected live. nullptr stops tracking.
+  void set_request_registry(std::shared_ptr<RequestRegistry> registry);
+
+  // Attribute wall time, thread CPU time and (with NEXUSMODS_WITH_ALLOC_HOOKS)
+  // heap allocations of every call to `metrics`, per endpoint and phase.
+  // nullptr turns it off.
+  void set_call_metrics(std::shared_ptr<CallMetrics> metrics);
+
+  ClientMetrics metrics_snapshot();
+
+  // Feed every response's X-RL-* headers to `budget` and hold each request
+  // for as long as its pacing policy asks. May be shared by clients using
+  // the same API key; nullptr turns pacing off.
+  void set_rate_limit_budget(std::shared_ptr<RateLimitBudget> budget);
+
+  // Called with every mod decoded by get_mod, get_latest_added,
+  // get_latest_updated and get_trending (projected calls excluded), on the
+  // requesting thread. Used to keep local indexes and stores up to date.
+  void add_mod_listener(std::function<void(const Mod &)> listener);
+
   // --- High level helpers for endpoints you requested ---
   // All return optional Document (parsed JSON) or std::nullopt on failure.
 
@@ -67,6 +188,9 @@ public:
   get_trending(const std::string &game_domain_name);
   std::optional<rapidjson::Document>
   get_mod(const std::string &game_domain_name, const std::string &mod_id);
+  std::optional<rapidjson::Document>
+  get_mod(const std::string &game_domain_name, const std::string &mod_id,
+          const FieldProjection &projection);
 
   std::optional<rapidjson::Document>
   md5_search(const std::string &game_domain_name, const std::string &md5_hash);
@@ -75,6 +199,10 @@ public:
   std::optional<rapidjson::Document>
   list_mod_files(const std::string &game_domain_name, const std::string &mod_id,
                  const httplib::Params &params = httplib::Params());
+  std::optional<rapidjson::Document>
+  list_mod_files(const std::string &game_domain_name, const std::string &mod_id,
+                 const FieldProjection &projection,
+                 const httplib::Params &params = httplib::Params());
 
   std::optional<rapidjson::Document>
   get_mod_file(const std::string &game_domain_name, const std::string &mod_id,
@@ -97,13 +225,38 @@ public:
   void set_backoff_callback(std::function<void(int)> cb);
 
 private:
-  httplib::SSLClient *client_;
-  std::string api_key_;
-  std::string api_header_name_; // default = "apikey"
-  std::string user_agent_;
-  std::mutex mutex_;
-  int timeout_seconds_;
-  std::function<void(int)> backoff_cb_;
+  // Everything plugged into the client, published like the config: setters
+  // copy, edit and swap it, requests read it without locking.
+  struct Components {
+    std::shared_ptr<Transport> transport;
+    std::shared_ptr<ParsePool> parse_pool;
+    std::shared_ptr<MemoryAccountant> memory;
+    MemoryAccountant::SubsystemId body_subsystem = 0;
+    std::shared_ptr<BufferPool> buffer_pool;
+    std::shared_ptr<Logger> logger;
+    std::shared_ptr<RequestRegistry> registry;
+    std::shared_ptr<CallMetrics> call_metrics;
+    std::shared_ptr<RateLimitBudget> rate_budget;
+    std::vector<std::function<void(const Mod &)>> mod_listeners;
+  };
+
+  std::mutex mutex_; // serializes config and component writers
+  const uint64_t instance_; // distinguishes clients in thread caches
+  std::atomic<std::shared_ptr<const ClientConfig>> config_;
+  std::atomic<uint64_t> config_version_{0};
+  std::atomic<std::shared_ptr<const Components>> components_;
+  std::atomic<uint64_t> components_version_{0};
+  std::vector<std::function<void()>> shutdown_hooks_; // guarded by mutex_
+
+  std::mutex shutdown_mutex_; // guards the fields below
+  std::condition_variable shutdown_cv_;
+  bool shutting_down_ = false;
+  bool hooks_due_ = false; // shutdown() called, hooks not yet run
+  int in_flight_ = 0;
+
+  // Current components, cached per thread as config() is.
+  std::shared_ptr<const Components> components() const;
+  void update_components(const std::function<void(Components &)> &edit);
 
   // Rate-limit helper
   std::optional<NexusResponse>
@@ -111,7 +264,45 @@ private:
                               const httplib::Params &params,
                               const httplib::Headers &extra_headers);
 
-  httplib::Headers build_auth_headers(const httplib::Headers &extra) const;
+  static httplib::Headers build_auth_headers(const ClientConfig &config,
+                                             const httplib::Headers &extra);
+
+  // Count a request in; false once shutting down.
+  bool enter_request();
+  void leave_request();
+  // Claims the shutdown hooks if they are due and nothing is in flight. The
+  // claim counts as a call in flight until finish_shutdown() drops it, so
+  // the destructor waits for the hooks.
+  bool take_hooks_locked();
+  void finish_shutdown();
+
+  // Keeps the client alive (for shutdown and the destructor) across a call,
+  // decoding included.
+  class InFlight {
+  public:
+    explicit InFlight(Client &c) : client_(c), entered_(c.enter_request()) {}
+    ~InFlight() {
+      if (entered_)
+        client_.leave_request();
+    }
+    InFlight(const InFlight &) = delete;
+    InFlight &operator=(const InFlight &) = delete;
+    explicit operator bool() const { return entered_; }
+
+  private:
+    Client &client_;
+    bool entered_;
+  };
+  // Sleep before a retry. False if shutdown cut it short.
+  bool backoff_sleep(std::chrono::milliseconds duration);
+  // Wait for in-flight calls to reach zero, up to `until`.
+  bool wait_drained(std::chrono::steady_clock::time_point until);
+
+  // Feed mods found in `doc` (one object or an array) to the listeners.
+  void notify_mods(const std::optional<rapidjson::Document> &doc);
+
+  // Account for a received body until the returned reservation is dropped.
+  MemoryReservation hold_body(const std::optional<NexusResponse> &r);
 };
 
 } // namespace nexusmods
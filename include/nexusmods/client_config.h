@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include "httplib.h"
+#include "nexusmods/rate_limit.h"
+
+namespace nexusmods {
+
+// How perform_get_with_rate_limit retries failed and rate-limited requests.
+struct RetryPolicy {
+  int max_attempts = 6;
+  int base_backoff_seconds = 1; // doubled per attempt
+};
+
+// Everything a request reads from the client's settings. Clients publish it
+// as an immutable snapshot: a request takes the current one when it starts
+// and uses it throughout, so reconfiguring never races with requests in
+// flight and never makes them wait.
+struct ClientConfig {
+  std::string api_key;
+  std::string api_header_name = "apikey";
+  std::string user_agent = "nexusmods-cpp/1.0";
+  httplib::Headers default_headers; // sent with every request
+  std::chrono::seconds timeout{30};
+  RetryPolicy retry;
+  // How a shared RateLimitBudget paces and counts this client's requests.
+  // Give batch jobs their own client with Bulk.
+  Priority priority = Priority::Interactive;
+  // Called with the seconds about to be slept before a retry.
+  std::function<void(int)> on_backoff;
+};
+
+} // namespace nexusmods
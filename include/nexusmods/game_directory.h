@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "nexusmods/types.h"
+
+namespace nexusmods {
+
+class Client;
+
+// Immutable lookup tables over a get_games() response: a minimal perfect
+// hash on domain names, a dense game id index and per-game categories
+// sorted by id.
+class GameTable {
+public:
+  GameTable() = default;
+  explicit GameTable(std::vector<Game> games);
+
+  const Game *by_domain(std::string_view domain_name) const;
+  const Game *by_id(int64_t id) const;
+  const GameCategory *category(const Game &game, int64_t category_id) const;
+
+  const std::vector<Game> &games() const { return games_; }
+  size_t size() const { return games_.size(); }
+
+private:
+  std::vector<Game> games_;
+  // Perfect hash: bucket -> seed, then seeded hash -> slot -> game index.
+  std::vector<uint32_t> seeds_;
+  std::vector<int32_t> slots_;
+  // Dense game id -> index into games_, -1 for unknown ids. Ids too large
+  // for a dense table go to a sorted side list instead.
+  std::vector<int32_t> by_id_;
+  std::vector<std::pair<int64_t, int32_t>> sparse_ids_;
+};
+
+// Keeps a GameTable current by calling get_games() in the background and
+// swapping in the new table atomically. Readers never lock: each thread
+// keeps the table it last saw and only touches shared state when a refresh
+// has been published since.
+class GameDirectory {
+public:
+  // Loads immediately on the background thread, then every `interval`.
+  explicit GameDirectory(Client &client,
+                         std::chrono::seconds interval = std::chrono::hours(24));
+  ~GameDirectory();
+
+  GameDirectory(const GameDirectory &) = delete;
+  GameDirectory &operator=(const GameDirectory &) = delete;
+
+  // Current table (empty until the first load). The reference stays valid
+  // until this thread calls current() on this directory again, or the
+  // directory is destroyed; use snapshot() to hold on to a table for longer.
+  const GameTable &current() const;
+  std::shared_ptr<const GameTable> snapshot() const;
+
+  // Fetch and publish now. Keeps the old table and returns false on failure.
+  bool refresh();
+
+  // Block until the first successful load or the timeout.
+  bool wait_ready(std::chrono::milliseconds timeout) const;
+
+private:
+  void run(std::chrono::seconds interval);
+
+  Client &client_;
+  const uint64_t instance_; // distinguishes directories in thread caches
+  // Expires with the directory, so thread caches can drop its slot.
+  const std::shared_ptr<const char> alive_;
+  std::atomic<std::shared_ptr<const GameTable>> table_;
+  std::atomic<uint64_t> version_{0};
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread refresher_;
+};
+
+} // namespace nexusmods
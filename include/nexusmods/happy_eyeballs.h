@@ -0,0 +1,28 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace nexusmods {
+
+struct RacedConnection {
+  int fd = -1;         // connected, non-blocking TCP socket; caller closes it
+  std::string address; // numeric address that won, e.g. "2606:4700::1"
+  int family = 0;      // AF_INET or AF_INET6
+};
+
+// RFC 8305 ("Happy Eyeballs v2") connection racing. Resolves `host`, orders
+// the addresses alternating between IPv6 and IPv4 (starting with whichever
+// family the resolver preferred), and starts a connect to the next address
+// every `stagger` or as soon as an earlier attempt fails. The first attempt
+// to complete wins and the rest are abandoned, so a dead address family costs
+// one stagger interval instead of a full connection timeout.
+//
+// nullopt if resolution fails or nothing connects within `timeout`.
+std::optional<RacedConnection>
+race_connect(const std::string &host, int port,
+             std::chrono::milliseconds timeout,
+             std::chrono::milliseconds stagger = std::chrono::milliseconds(250));
+
+} // namespace nexusmods
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rapidjson/document.h"
+
+namespace nexusmods {
+
+class LazyDocument;
+
+// Handle to one value of a LazyDocument. Nothing is decoded until one of the
+// get_* accessors or materialize() is called. A handle stays valid as long as
+// its document is neither moved nor destroyed.
+//
+//   auto files = client.get_json_lazy(path);
+//   for (auto f : files->root()["files"].elements())
+//     if (f["category_name"].get_string() == "MAIN") ...
+class LazyValue {
+public:
+  enum class Kind { Missing, Null, Bool, Number, String, Object, Array };
+
+  LazyValue() = default;
+
+  Kind kind() const;
+  bool exists() const { return doc_ != nullptr; }
+  bool is_object() const { return kind() == Kind::Object; }
+  bool is_array() const { return kind() == Kind::Array; }
+
+  // Member lookup on objects and element access on arrays. Both return a
+  // Missing value instead of failing, so lookups can be chained.
+  LazyValue operator[](std::string_view key) const;
+  LazyValue operator[](size_t index) const;
+
+  // Number of array elements or object members; 0 for anything else.
+  size_t size() const;
+
+  std::optional<bool> get_bool() const;
+  std::optional<int64_t> get_int64() const;
+  std::optional<double> get_double() const;
+  std::optional<std::string> get_string() const;
+
+  // Unparsed JSON text of this value.
+  std::string_view raw() const;
+
+  // Parse this value (and only this value) into a RapidJSON DOM.
+  rapidjson::Document materialize() const;
+
+  // Iteration over array elements, or over (key, value) pairs of an object.
+  template <typename T> class Range;
+  Range<LazyValue> elements() const;
+  Range<std::pair<LazyValue, LazyValue>> members() const;
+
+private:
+  friend class LazyDocument;
+  LazyValue(const LazyDocument *doc, uint32_t token)
+      : doc_(doc), token_(token) {}
+
+  // Index of the token following the subtree rooted at `token`.
+  static uint32_t skip(const LazyDocument *doc, uint32_t token);
+
+  const LazyDocument *doc_ = nullptr;
+  uint32_t token_ = 0;
+};
+
+// Raw response body plus a structural index of where every value starts and
+// ends. Indexing is a single pass over the bytes and does not validate
+// scalars; malformed values surface as nullopt from the accessors.
+class LazyDocument {
+public:
+  LazyDocument() = default;
+  explicit LazyDocument(std::string body);
+
+  LazyDocument(LazyDocument &&) = default;
+  LazyDocument &operator=(LazyDocument &&) = default;
+
+  bool has_error() const { return error_offset_.has_value(); }
+  // Byte offset of the first structural error, if any.
+  std::optional<size_t> error_offset() const { return error_offset_; }
+
+  LazyValue root() const;
+  const std::string &body() const { return body_; }
+
+private:
+  friend class LazyValue;
+
+  struct Token {
+    uint32_t begin; // offset of the first byte
+    uint32_t end;   // one past the last byte
+    uint32_t next;  // index of the token following this value's subtree
+    char type;      // '{', '[', '"', 't', 'f', 'n' (null) or '0' (number)
+  };
+
+  void build_index();
+
+  std::string body_;
+  std::vector<Token> tokens_;
+  std::optional<size_t> error_offset_;
+};
+
+template <typename T> class LazyValue::Range {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = T;
+
+    iterator() = default;
+    iterator(const LazyDocument *doc, uint32_t token)
+        : doc_(doc), token_(token) {}
+
+    T operator*() const {
+      if constexpr (std::is_same_v<T, LazyValue>)
+        return LazyValue(doc_, token_);
+      else
+        return {LazyValue(doc_, token_), LazyValue(doc_, token_ + 1)};
+    }
+    iterator &operator++() {
+      // Object members are a key token followed by the value's subtree.
+      token_ = LazyValue::skip(
+          doc_, std::is_same_v<T, LazyValue> ? token_ : token_ + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool operator==(const iterator &o) const { return token_ == o.token_; }
+    bool operator!=(const iterator &o) const { return token_ != o.token_; }
+
+  private:
+    const LazyDocument *doc_ = nullptr;
+    uint32_t token_ = 0;
+  };
+
+  Range(iterator b, iterator e) : begin_(b), end_(e) {}
+  iterator begin() const { return begin_; }
+  iterator end() const { return end_; }
+
+private:
+  iterator begin_, end_;
+};
+
+} // namespace nexusmods
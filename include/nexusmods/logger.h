@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace nexusmods {
+
+enum class LogEvent : uint8_t {
+  RequestStart,
+  RequestDone, // value: elapsed microseconds
+  Retry,       // value: 0 transport error, 1 HTTP 429, 2 daily, 3 hourly limit
+  Backoff,     // value: seconds about to be slept
+};
+
+std::string_view to_string(LogEvent event);
+
+// Fixed-size, trivially copyable so it can sit in a ring slot.
+struct LogRecord {
+  int64_t time_ns = 0; // system_clock, since the epoch
+  uint64_t thread = 0; // hash of the logging thread's id
+  LogEvent event = LogEvent::RequestStart;
+  int32_t status = 0; // HTTP status, -1 without a response
+  int32_t attempt = 0;
+  int64_t value = 0;    // see LogEvent
+  char path[80] = {};   // request path, truncated, NUL-terminated
+};
+
+// Structured logger that keeps formatting and I/O off the request threads.
+// Each logging thread gets its own single-producer ring of LogRecords, so
+// log() is a copy and a release store with no lock or allocation after the
+// thread's first record. A background thread drains the rings every
+// `drain_interval`, orders the batch by time and hands it to the sink.
+//
+// A record that finds its ring full is dropped and counted rather than
+// making the request thread wait.
+class Logger {
+public:
+  // Called on the drain thread only.
+  using Sink = std::function<void(const LogRecord *records, size_t count)>;
+
+  explicit Logger(
+      Sink sink, size_t ring_capacity = 1024,
+      std::chrono::milliseconds drain_interval = std::chrono::milliseconds(50));
+
+  // Drains what has been logged, then stops the drain thread.
+  ~Logger();
+
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  void log(const LogRecord &record);
+  void log(LogEvent event, std::string_view path, int32_t status = 0,
+           int32_t attempt = 0, int64_t value = 0);
+
+  // Block until everything logged before the call has reached the sink.
+  void flush();
+
+  // Records lost to full rings so far.
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // One line per record: "<time_ns> <thread> <event> <path> status=..
+  // attempt=.. value=..".
+  static Sink text_sink(std::ostream &out);
+
+private:
+  struct Ring;
+
+  Ring &ring_for_this_thread();
+  void run();
+  void drain_once(std::vector<LogRecord> &batch);
+
+  const uint64_t id_;
+  const size_t ring_capacity_;
+  const std::chrono::milliseconds drain_interval_;
+  Sink sink_;
+  std::atomic<uint64_t> dropped_{0};
+
+  std::mutex rings_mutex_; // taken once per thread, and by the drain thread
+  std::vector<std::shared_ptr<Ring>> rings_;
+
+  std::mutex mutex_; // drain thread wake-ups and flush hand-off
+  std::condition_variable cv_;
+  uint64_t flush_requested_ = 0;
+  uint64_t flush_done_ = 0;
+  bool stop_ = false;
+  std::thread drainer_;
+};
+
+} // namespace nexusmods
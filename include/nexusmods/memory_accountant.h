@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nexusmods {
+
+class MemoryAccountant;
+
+// Bytes charged to one subsystem, released on destruction. Keeps its
+// accountant alive, so it may outlive the owner that charged it.
+class MemoryReservation {
+public:
+  MemoryReservation() = default;
+  MemoryReservation(MemoryReservation &&o) noexcept;
+  MemoryReservation &operator=(MemoryReservation &&o) noexcept;
+  MemoryReservation(const MemoryReservation &) = delete;
+  MemoryReservation &operator=(const MemoryReservation &) = delete;
+  ~MemoryReservation() { reset(); }
+
+  size_t bytes() const { return bytes_; }
+  void reset();
+
+private:
+  friend class MemoryAccountant;
+  MemoryReservation(std::shared_ptr<MemoryAccountant> owner, size_t id,
+                    size_t bytes)
+      : owner_(std::move(owner)), id_(id), bytes_(bytes) {}
+
+  std::shared_ptr<MemoryAccountant> owner_;
+  size_t id_ = 0;
+  size_t bytes_ = 0;
+};
+
+// Process-wide memory budget shared by the client's subsystems (response
+// bodies, buffer pools, caches...). Each subsystem charges what it holds;
+// when the total reaches the cap, subsystems with an evictor are asked to
+// shrink and new requests wait in wait_for_headroom() until usage drops.
+//
+// Must be owned by a shared_ptr: reservations hold a reference to it.
+class MemoryAccountant
+    : public std::enable_shared_from_this<MemoryAccountant> {
+public:
+  using SubsystemId = size_t;
+
+  // Called with the number of bytes the accountant would like freed. Must be
+  // thread-safe and must not reserve; it reports what it dropped through
+  // release() (or by destroying reservations).
+  using Evictor = std::function<void(size_t bytes_wanted)>;
+
+  struct Usage {
+    std::string name;
+    size_t used = 0;
+    size_t peak = 0;
+  };
+
+  struct Snapshot {
+    size_t cap = 0;
+    size_t used = 0;
+    size_t evictions = 0;      // evictor invocations
+    size_t throttled_waits = 0; // wait_for_headroom calls that had to block
+    std::vector<Usage> subsystems;
+  };
+
+  explicit MemoryAccountant(size_t cap_bytes);
+
+  MemoryAccountant(const MemoryAccountant &) = delete;
+  MemoryAccountant &operator=(const MemoryAccountant &) = delete;
+
+  SubsystemId register_subsystem(const std::string &name,
+                                 Evictor evict = nullptr);
+  // The subsystem called `name` without an evictor, registered on first
+  // use. Lets several owners (e.g. clients) charge one row.
+  SubsystemId subsystem(const std::string &name);
+
+  // Account for memory that is already allocated. Always succeeds, even over
+  // the cap; later admissions then wait until it is released.
+  MemoryReservation charge(SubsystemId id, size_t bytes);
+
+  // Reserve room for an optional allocation (e.g. a cache entry), evicting
+  // first if needed. nullopt if the budget can't accommodate it.
+  std::optional<MemoryReservation> try_reserve(SubsystemId id, size_t bytes);
+
+  // Manual counterparts for subsystems tracking many small objects.
+  bool try_add(SubsystemId id, size_t bytes);
+  void release(SubsystemId id, size_t bytes);
+
+  // Admission control: block until usage is below the cap, evicting caches
+  // along the way. Returns false if the deadline passed first.
+  bool wait_for_headroom(std::chrono::steady_clock::duration max_wait);
+
+  void set_cap(size_t cap_bytes);
+  size_t cap() const;
+  size_t used() const;
+  Snapshot snapshot() const;
+
+private:
+  struct Subsystem {
+    Usage usage;
+    Evictor evict;
+  };
+
+  void add_locked(SubsystemId id, size_t bytes);
+  // Run evictors (without holding mutex_) until `bytes_wanted` is freed or
+  // every evictor has been asked once.
+  void evict(size_t bytes_wanted);
+
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  size_t cap_;
+  size_t used_ = 0;
+  size_t evictions_ = 0;
+  size_t throttled_waits_ = 0;
+  std::vector<Subsystem> subsystems_;
+};
+
+} // namespace nexusmods
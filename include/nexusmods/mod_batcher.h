@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rapidjson/document.h"
+
+namespace nexusmods {
+
+class Client;
+
+// Front end for Client::get_mod that fetches lookups on `max_parallel`
+// workers and lets concurrent lookups of the same mod share one request: a
+// lookup joins any request for that mod that is queued or already on the
+// wire. Each waiter then gets its own copy of the result.
+//
+// Optionally, lookups are also held back for a short `window` and dispatched
+// together (early once `max_batch` are waiting), so that bursts deduplicate
+// better. That costs every lookup up to the window in latency and is off by
+// default.
+//
+// The v1 API has no bulk mod endpoint, so parallel lookups are separate REST
+// calls. They only overlap on a transport with several connections, such as
+// UringTransport; HttplibTransport runs one request at a time, and there the
+// batcher saves only the deduplicated requests, not wall time.
+class ModBatcher {
+public:
+  struct Options {
+    std::chrono::milliseconds window{0}; // 0: dispatch lookups right away
+    size_t max_batch = 64;               // with a window: dispatch early
+    size_t max_parallel = 8;
+  };
+
+  struct Stats {
+    uint64_t lookups = 0;      // get_mod / get_mod_async calls
+    uint64_t deduplicated = 0; // served by another lookup's request
+    uint64_t batches = 0;      // windows dispatched
+    uint64_t fetches = 0;      // requests made to the client
+  };
+
+  explicit ModBatcher(Client &client);
+  ModBatcher(Client &client, Options options);
+  // Fetches whatever is still queued, then stops the workers.
+  ~ModBatcher();
+
+  ModBatcher(const ModBatcher &) = delete;
+  ModBatcher &operator=(const ModBatcher &) = delete;
+
+  std::future<std::optional<rapidjson::Document>>
+  get_mod_async(const std::string &game_domain_name, const std::string &mod_id);
+
+  // Same result as Client::get_mod; an exception it throws is rethrown to
+  // every lookup that shared the request.
+  std::optional<rapidjson::Document> get_mod(const std::string &game_domain_name,
+                                             const std::string &mod_id);
+
+  Stats stats() const;
+
+private:
+  using Key = std::pair<std::string, std::string>; // domain, mod id
+  using Promise = std::promise<std::optional<rapidjson::Document>>;
+
+  void collect();
+  void work();
+
+  Client &client_;
+  const Options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable collector_cv_;
+  std::condition_variable worker_cv_;
+  // Every mod with lookups outstanding, from the window until its request
+  // returns; a key here means a request for it is coming.
+  std::map<Key, std::vector<Promise>> waiters_;
+  std::vector<Key> window_; // held back in the current window
+  std::chrono::steady_clock::time_point window_end_;
+  std::deque<Key> jobs_; // dispatched, waiting for a worker
+  bool stop_ = false;
+  bool workers_stop_ = false; // workers exit once set and jobs_ is empty
+  Stats stats_;
+
+  std::thread collector_;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace nexusmods
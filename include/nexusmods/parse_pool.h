@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+#include "nexusmods/mpmc_queue.h"
+
+namespace nexusmods {
+
+// Fixed set of CPU threads that decode responses handed over by request
+// threads. Jobs travel through a lock-free queue; idle workers park on a
+// semaphore. Can be shared by several Clients.
+class ParsePool {
+public:
+  explicit ParsePool(size_t threads = std::thread::hardware_concurrency(),
+                     size_t queue_capacity = 1024);
+
+  // Runs every job already queued, then joins the workers.
+  ~ParsePool();
+
+  ParsePool(const ParsePool &) = delete;
+  ParsePool &operator=(const ParsePool &) = delete;
+
+  // Queue `job`. Returns false when the queue is full, in which case the
+  // caller should run the job itself.
+  bool try_submit(std::function<void()> job);
+
+  size_t thread_count() const { return workers_.size(); }
+
+private:
+  void run();
+
+  MpmcQueue<std::function<void()>> queue_;
+  std::counting_semaphore<> pending_{0};
+  std::atomic<bool> stop_{false};
+  std::vector<std::thread> workers_;
+};
+
+} // namespace nexusmods
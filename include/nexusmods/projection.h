@@ -0,0 +1,48 @@
+#pragma once
+
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "rapidjson/document.h"
+
+namespace nexusmods {
+
+// Set of fields to keep when decoding a response. Paths are dot separated
+// object keys ("user.name"); arrays are transparent, so "files.file_id"
+// keeps file_id of every element of the "files" array, and a projection on
+// an endpoint returning a top-level array applies to each element. An empty
+// projection keeps everything.
+//
+//   static const FieldProjection summary{"mod_id", "name", "version"};
+//   auto doc = client.get_mod("skyrim", "1234", summary);
+class FieldProjection {
+public:
+  struct Node {
+    bool whole = false; // keep the full subtree below this node
+    std::map<std::string, Node, std::less<>> children;
+  };
+
+  FieldProjection() = default;
+  FieldProjection(std::initializer_list<std::string_view> paths);
+
+  // Add a dot separated path. Adding a parent of an existing path keeps the
+  // whole parent.
+  FieldProjection &add(std::string_view path);
+
+  bool empty() const { return root_.children.empty() && !root_.whole; }
+  const Node &root() const { return root_; }
+
+private:
+  Node root_;
+};
+
+// Parse `json` keeping only the projected fields. The buffer is parsed in
+// place: it is modified and must not be reused afterwards. Skipped values are
+// tokenized but never copied into the document.
+rapidjson::ParseResult parse_projected(std::string &json,
+                                       const FieldProjection &projection,
+                                       rapidjson::Document &out);
+
+} // namespace nexusmods
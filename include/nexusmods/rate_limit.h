@@ -0,0 +1,173 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "httplib.h"
+
+namespace nexusmods {
+
+// Parses the date formats the API uses in Retry-After and X-RL-*-Reset:
+// RFC 1123 ("Wed, 21 Oct 2015 07:28:00 GMT"), "2019-02-02 00:00:00 +0000"
+// and "2019-02-02T00:00:00". All are taken as UTC.
+std::optional<std::chrono::system_clock::time_point>
+parse_rate_limit_date(const std::string &date);
+
+enum class Priority : uint8_t {
+  Interactive, // someone is waiting on the answer
+  Bulk,        // crawls, syncs, exports
+};
+
+// Quota as last reported by the X-RL-* headers, rolled forward past any
+// reset that has happened since. The API allows a request while either
+// quota has requests left: the daily one is spent first, after which the
+// hourly one applies.
+struct RateLimitState {
+  using TimePoint = std::chrono::system_clock::time_point;
+
+  bool known = false; // no X-RL headers seen yet
+  int64_t hourly_limit = 0;
+  int64_t hourly_remaining = 0;
+  TimePoint hourly_reset;
+  int64_t daily_limit = 0;
+  int64_t daily_remaining = 0;
+  TimePoint daily_reset;
+  TimePoint last_sent; // when the budget last recorded a request
+
+  // Requests that can be sent before next_reset().
+  int64_t available() const;
+  TimePoint next_reset() const;
+};
+
+// Where the quota is heading at the current request rates.
+struct RateLimitForecast {
+  using TimePoint = RateLimitState::TimePoint;
+
+  double interactive_per_hour = 0; // smoothed send rates
+  double bulk_per_hour = 0;
+  int64_t available = 0; // RateLimitState::available()
+  TimePoint next_reset;
+  // Requests expected to be left at next_reset; negative is a shortfall.
+  double left_at_reset = 0;
+  // When the quota runs out at the current rates, if before next_reset.
+  std::optional<TimePoint> exhausted_at;
+  // Held back from Bulk requests until next_reset.
+  int64_t interactive_reserve = 0;
+};
+
+// Decides when a request may go out, given the budget's view of the quota.
+class PacingPolicy {
+public:
+  virtual ~PacingPolicy() = default;
+
+  // Zero to send now.
+  virtual std::chrono::milliseconds delay(const RateLimitState &state,
+                                          RateLimitState::TimePoint now,
+                                          Priority priority) const = 0;
+};
+
+// Send as fast as the quota allows, then wait for the reset.
+class BurstPacing : public PacingPolicy {
+public:
+  std::chrono::milliseconds delay(const RateLimitState &state,
+                                  RateLimitState::TimePoint now,
+                                  Priority priority) const override;
+};
+
+// Spread what is left evenly over the time until the reset.
+class EvenPacing : public PacingPolicy {
+public:
+  std::chrono::milliseconds delay(const RateLimitState &state,
+                                  RateLimitState::TimePoint now,
+                                  Priority priority) const override;
+};
+
+// Keep `reserve` of the current window's quota for Interactive requests.
+// Bulk requests are paced by `bulk` against what remains above the
+// reserve; Interactive ones by `interactive` against the whole quota.
+class PriorityPacing : public PacingPolicy {
+public:
+  PriorityPacing(double reserve, std::shared_ptr<PacingPolicy> bulk,
+                 std::shared_ptr<PacingPolicy> interactive);
+
+  std::chrono::milliseconds delay(const RateLimitState &state,
+                                  RateLimitState::TimePoint now,
+                                  Priority priority) const override;
+
+private:
+  double reserve_;
+  std::shared_ptr<PacingPolicy> bulk_;
+  std::shared_ptr<PacingPolicy> interactive_;
+};
+
+// Tracks the quota across responses and asks a pacing policy how long each
+// request should wait. Thread-safe; share one per API key. The clock is
+// injectable so the same object can run under a simulator.
+class RateLimitBudget {
+public:
+  using Clock = std::chrono::system_clock;
+  using NowFn = std::function<Clock::time_point()>;
+
+  // Without a policy, delay() is always zero and the budget only tracks.
+  explicit RateLimitBudget(std::shared_ptr<PacingPolicy> policy = nullptr,
+                           NowFn now = nullptr);
+
+  // Record the X-RL-* headers of a response; other headers are ignored.
+  void observe(const httplib::Headers &headers);
+  void observe(const RateLimitState &reported);
+
+  struct AdmissionOptions {
+    // Smallest share of the current window kept for Interactive requests.
+    double min_reserve = 0.1;
+    // Multiplies the forecast Interactive demand, to cover bursts.
+    double demand_margin = 2.0;
+    // Time constant of the send-rate averages.
+    std::chrono::seconds rate_window{300};
+  };
+
+  void set_admission_options(AdmissionOptions options);
+
+  // Count a request sent, ahead of the response that will report it.
+  void on_sent(Priority priority = Priority::Interactive);
+
+  RateLimitForecast forecast() const;
+
+  // Admission control for work that can wait: true if `n` requests of
+  // `priority` fit in the quota now. Bulk requests must also leave the
+  // Interactive reserve intact: the larger of min_reserve and the
+  // Interactive demand forecast until the next reset, times demand_margin.
+  // Callers told no should ask again later, at the latest at
+  // forecast().next_reset. Always true before any X-RL headers were seen.
+  bool may_spend(int64_t n, Priority priority = Priority::Bulk) const;
+
+  std::chrono::milliseconds delay(Priority priority = Priority::Interactive)
+      const;
+
+  RateLimitState state() const;
+  Clock::time_point now() const { return now_(); }
+
+private:
+  // Events per second, exponentially weighted with time constant `tau`.
+  struct Rate {
+    double per_second = 0;
+    Clock::time_point at;
+    double at_time(Clock::time_point now, double tau) const;
+  };
+
+  const RateLimitState &state_locked(Clock::time_point now) const;
+  RateLimitForecast forecast_locked(Clock::time_point now) const;
+
+  std::shared_ptr<PacingPolicy> policy_;
+  NowFn now_;
+  mutable std::mutex mutex_;
+  mutable RateLimitState state_; // resets are applied lazily, on read
+  AdmissionOptions admission_;
+  Rate rates_[2]; // by Priority
+};
+
+} // namespace nexusmods
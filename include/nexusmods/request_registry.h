@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nexusmods {
+
+class RequestRegistry;
+
+// What a tracked request is doing right now.
+enum class RequestState : uint8_t {
+  WaitingForMemory,     // held back by the MemoryAccountant
+  WaitingForConnection, // queued behind other requests on the transport
+  InTransport,          // connecting, sending, or waiting for response headers
+  ReadingBody,          // headers received, body streaming in
+  BackingOff,           // sleeping before the next attempt
+};
+
+const char *to_string(RequestState state);
+
+// RAII registration of one request; updates are relaxed atomic stores, so
+// they cost the request thread nothing measurable. A default-constructed
+// tracker (no registry) ignores every call.
+class RequestTracker {
+public:
+  RequestTracker() = default;
+  RequestTracker(RequestTracker &&o) noexcept;
+  RequestTracker &operator=(RequestTracker &&o) noexcept;
+  RequestTracker(const RequestTracker &) = delete;
+  RequestTracker &operator=(const RequestTracker &) = delete;
+  ~RequestTracker();
+
+  void set_state(RequestState state);
+  void set_attempt(int attempt);
+  // BackingOff until now + `sleep`.
+  void backing_off(std::chrono::milliseconds sleep);
+
+  struct Entry;
+
+private:
+  friend class RequestRegistry;
+  RequestTracker(RequestRegistry *registry, std::shared_ptr<Entry> entry)
+      : registry_(registry), entry_(std::move(entry)) {}
+
+  RequestRegistry *registry_ = nullptr;
+  std::shared_ptr<Entry> entry_;
+};
+
+// Live view of every request a Client has in flight. Requests register on
+// one of several shards, each with its own short lock; snapshot() visits
+// the shards one at a time and reads each request's state atomically, so
+// it never blocks more than a handful of registrations at once and never
+// pauses a request that is already running.
+//
+// May be shared between clients; must outlive the requests it tracks.
+class RequestRegistry {
+public:
+  struct RequestInfo {
+    uint64_t id = 0;
+    std::string path;
+    RequestState state = RequestState::InTransport;
+    int attempt = 0;
+    std::chrono::milliseconds elapsed{0};
+    std::chrono::milliseconds wake_in{0}; // BackingOff only: time left asleep
+  };
+
+  RequestRegistry() = default;
+  RequestRegistry(const RequestRegistry &) = delete;
+  RequestRegistry &operator=(const RequestRegistry &) = delete;
+
+  RequestTracker track(const std::string &path);
+
+  // Oldest request first.
+  std::vector<RequestInfo> snapshot() const;
+
+  // snapshot() as a JSON array of objects with the RequestInfo field names
+  // (durations in milliseconds, state as a string).
+  std::string to_json() const;
+
+private:
+  friend class RequestTracker;
+  void untrack(const RequestTracker::Entry &entry);
+
+  static constexpr size_t kShards = 16;
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<RequestTracker::Entry>> entries;
+  };
+
+  std::atomic<uint64_t> next_id_{1};
+  std::array<Shard, kShards> shards_;
+};
+
+// Serves a registry over plain HTTP for debugging a running process:
+//   GET /requests      -> RequestRegistry::to_json()
+//   GET /              -> the same as a text table
+// Bind it to a loopback address; there is no authentication.
+class RequestDebugServer {
+public:
+  explicit RequestDebugServer(std::shared_ptr<RequestRegistry> registry);
+  ~RequestDebugServer(); // stops the server
+
+  RequestDebugServer(const RequestDebugServer &) = delete;
+  RequestDebugServer &operator=(const RequestDebugServer &) = delete;
+
+  // Start listening on a background thread. `port` 0 picks a free port.
+  // Returns the bound port, or -1 if binding failed.
+  int start(const std::string &host = "127.0.0.1", int port = 0);
+  void stop();
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace nexusmods
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "nexusmods/types.h"
+
+namespace nexusmods {
+
+// In-memory trigram index over mod name, author and summary. Mods are added
+// (or replaced) one at a time, typically from Client::add_mod_listener, and
+// queries rank by IDF-weighted trigram overlap with name matches counting
+// most. Thread-safe: searches run concurrently, updates are exclusive.
+//
+//   SearchIndex index;
+//   client.add_mod_listener([&](const Mod &m) { index.add(m); });
+//   for (auto &hit : index.search("unofficial patch")) ...
+class SearchIndex {
+public:
+  struct Hit {
+    int64_t game_id;
+    int64_t mod_id;
+    float score;
+  };
+
+  // Insert `mod`, replacing any previous version of it.
+  void add(const Mod &mod);
+  void remove(int64_t game_id, int64_t mod_id);
+
+  // Best `limit` matches for `query`, highest score first. Queries shorter
+  // than two characters return nothing.
+  std::vector<Hit> search(std::string_view query, size_t limit = 20) const;
+
+  size_t size() const;
+
+private:
+  struct Doc {
+    int64_t game_id;
+    int64_t mod_id;
+    bool live;
+  };
+  struct Posting {
+    uint32_t doc;
+    float weight;
+  };
+
+  static uint64_t key(int64_t game_id, int64_t mod_id) {
+    return (static_cast<uint64_t>(game_id) << 32) ^
+           static_cast<uint64_t>(mod_id);
+  }
+
+  void remove_locked(uint64_t k);
+  // Drop postings of removed documents once they dominate the index.
+  void maybe_compact_locked();
+
+  mutable std::shared_mutex mutex_;
+  std::vector<Doc> docs_;
+  std::unordered_map<uint64_t, uint32_t> by_key_;
+  std::unordered_map<uint32_t, std::vector<Posting>> postings_;
+  size_t live_ = 0;
+};
+
+} // namespace nexusmods
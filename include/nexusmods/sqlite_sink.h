@@ -0,0 +1,59 @@
+#pragma once
+
+// Only available when the library is configured with
+// -DNEXUSMODS_WITH_SQLITE=ON (requires SQLite >= 3.24 for upserts).
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "nexusmods/change_log.h"
+#include "nexusmods/types.h"
+
+namespace nexusmods {
+
+// Writes typed catalog records into a SQLite database (tables mods, files,
+// games and categories, created if missing). Rows are upserted through
+// prepared statements inside large transactions committed every
+// `batch_rows` rows, with the database in WAL mode and synchronous=NORMAL,
+// so bulk loads aren't bound by per-row fsyncs.
+//
+//   SqliteSink db;
+//   db.open("catalog.db");
+//   ChangeLogReader changes("/var/lib/nexus/changes", saved_cursor);
+//   while (auto c = changes.next()) db.apply(*c);
+//   db.commit();
+class SqliteSink {
+public:
+  struct Options {
+    size_t batch_rows = 50 * 1000;
+    bool wal = true;
+  };
+
+  SqliteSink();
+  ~SqliteSink(); // commits and closes if still open
+
+  SqliteSink(const SqliteSink &) = delete;
+  SqliteSink &operator=(const SqliteSink &) = delete;
+
+  // All calls return false on failure; last_error() says why.
+  bool open(const std::string &path);
+  bool open(const std::string &path, Options options);
+  bool upsert(const Mod &mod);
+  bool upsert(const ModFile &file); // file.game_id must be set
+  bool upsert(const Game &game); // with its categories
+  // Decode a CatalogSync change record and upsert the object it carries.
+  bool apply(const ChangeRecord &change);
+  // Commit the open transaction now (the next write starts a new one).
+  bool commit();
+  bool close();
+
+  size_t rows_written() const;
+  const std::string &last_error() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace nexusmods
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nexusmods/types.h"
+
+namespace nexusmods {
+
+// Compact in-memory time series of per-mod counters, fed from polled Mod
+// records. Each (mod, metric) series is split into chunks of up to 256
+// samples; inside a chunk both timestamps and values are stored as
+// delta-of-deltas in a Gorilla-style variable-length bit stream, so a
+// steadily polled counter costs one or two bits per sample.
+//
+//   StatsStore stats;
+//   client.add_mod_listener([&](const Mod &m) { stats.record(m); });
+//   auto week = stats.range(game_id, mod_id, StatsStore::Metric::Downloads,
+//                           now - 7 * 86400, now);
+class StatsStore {
+public:
+  enum class Metric : uint8_t { Downloads, UniqueDownloads, Endorsements };
+
+  struct Point {
+    int64_t timestamp; // unix seconds
+    int64_t value;
+  };
+
+  // Append every metric of `mod`, timestamped now unless given.
+  void record(const Mod &mod, std::optional<int64_t> timestamp = std::nullopt);
+
+  // Samples must arrive in timestamp order per series; older ones are
+  // rejected (returns false). A repeated timestamp replaces nothing and is
+  // stored as another sample.
+  bool append(int64_t game_id, int64_t mod_id, Metric metric,
+              int64_t timestamp, int64_t value);
+
+  // Samples with from <= timestamp <= to, oldest first.
+  std::vector<Point> range(int64_t game_id, int64_t mod_id, Metric metric,
+                           int64_t from, int64_t to) const;
+  std::optional<Point> latest(int64_t game_id, int64_t mod_id,
+                              Metric metric) const;
+
+  size_t series_count() const;
+  size_t sample_count() const;
+  size_t memory_bytes() const; // chunk storage, excluding the series map
+
+  // Binary snapshot of every series. load() replaces the current contents.
+  bool save(const std::string &path) const;
+  bool load(const std::string &path);
+
+private:
+  struct Chunk {
+    int64_t first_ts = 0;
+    int64_t last_ts = 0;
+    uint32_t count = 0;
+    uint64_t bits = 0; // used bits in `words`
+    std::vector<uint64_t> words;
+  };
+
+  struct Series {
+    std::vector<Chunk> chunks;
+    // Encoder state for the last chunk.
+    int64_t prev_ts = 0, prev_ts_delta = 0;
+    int64_t prev_value = 0, prev_value_delta = 0;
+  };
+
+  struct Key {
+    int64_t game_id;
+    int64_t mod_id;
+    Metric metric;
+    bool operator==(const Key &o) const {
+      return game_id == o.game_id && mod_id == o.mod_id && metric == o.metric;
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const Key &k) const;
+  };
+
+  static void encode(Series &s, int64_t timestamp, int64_t value);
+  template <typename F> static void decode(const Chunk &c, F &&visit);
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<Key, Series, KeyHash> series_;
+};
+
+} // namespace nexusmods
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <openssl/ssl.h>
+
+namespace httplib {
+class SSLClient;
+}
+
+namespace nexusmods {
+
+// One client-side TLS setup shared by every connection the library opens:
+// the CA bundle is parsed once into a single X509_STORE, and TLS sessions are
+// cached per server name for resumption. Immutable after construction apart
+// from the session cache, which is internally locked.
+//
+// httplib clients can only share the CA store (httplib builds its own
+// SSL_CTX per client, see configure()); transports that create SSL objects themselves, such as
+// UringTransport, use ssl_ctx() and the session cache directly.
+class TlsContext {
+public:
+  // Process-wide context using the system's default CA locations.
+  static std::shared_ptr<TlsContext> shared();
+  // Context trusting only the PEM bundle at `ca_file`.
+  static std::shared_ptr<TlsContext> from_ca_file(const std::string &ca_file);
+
+  ~TlsContext();
+
+  TlsContext(const TlsContext &) = delete;
+  TlsContext &operator=(const TlsContext &) = delete;
+
+  // False if OpenSSL couldn't build the context or load any CA.
+  bool is_valid() const { return ctx_ != nullptr; }
+
+  // Borrowed pointers; valid for the lifetime of this object. Up-ref the
+  // store before handing it to anything that takes ownership.
+  SSL_CTX *ssl_ctx() const { return ctx_; }
+  X509_STORE *ca_store() const;
+
+  // Points an httplib client for `host` at the shared CA store and has
+  // OpenSSL verify chain and host name in the handshake. No-op unless
+  // is_valid(), leaving httplib to load the system CAs itself.
+  void configure(httplib::SSLClient &client, const std::string &host) const;
+
+  // Removes and returns the cached session for `server_name` (caller owns
+  // it), or nullptr. TLS 1.3 tickets are single-use, so a session is handed
+  // out once; the resumed connection delivers fresh ones.
+  SSL_SESSION *take_session(const std::string &server_name);
+
+private:
+  explicit TlsContext(const std::string &ca_file);
+  static int on_new_session(SSL *ssl, SSL_SESSION *session);
+
+  SSL_CTX *ctx_ = nullptr;
+  std::mutex mutex_;
+  std::unordered_map<std::string, SSL_SESSION *> sessions_;
+};
+
+} // namespace nexusmods
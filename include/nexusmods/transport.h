@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "httplib.h"
+#include "nexusmods/tls_context.h"
+
+namespace nexusmods {
+
+// What Client uses to put a GET on the wire. Implementations must be safe to
+// call from several threads at once. The handlers follow httplib's streaming
+// contract: `on_response` sees status and headers before any body bytes, then
+// `on_data` receives the body in pieces; returning false from either cancels
+// the request. The Result carries the Response (without body) on success.
+class Transport {
+public:
+  virtual ~Transport() = default;
+
+  virtual httplib::Result get(const std::string &path,
+                              const httplib::Params &params,
+                              const httplib::Headers &headers,
+                              httplib::ResponseHandler on_response,
+                              httplib::ContentReceiver on_data) = 0;
+
+  // Applied to connect, read and write individually. Called while requests
+  // are in flight, so it must not wait for them; it may take effect from the
+  // next request.
+  virtual void set_timeout(std::chrono::seconds timeout) = 0;
+
+  // Make every request in flight fail promptly (Error::Canceled or a read
+  // error), including those still waiting for a connection, and don't resend
+  // them; the transport stays usable for new requests. Used by
+  // Client::shutdown once its deadline has passed.
+  virtual void cancel_all() {}
+
+  // Runs `hook` once a get() made on this thread while the scope is alive
+  // has a connection to send on. Client uses it to tell requests queued
+  // behind others on the transport apart from those on the wire.
+  class ConnectionHook {
+  public:
+    explicit ConnectionHook(std::function<void()> hook);
+    ~ConnectionHook();
+
+    ConnectionHook(const ConnectionHook &) = delete;
+    ConnectionHook &operator=(const ConnectionHook &) = delete;
+
+  private:
+    friend class Transport;
+    std::function<void()> hook_;
+    ConnectionHook *outer_;
+  };
+
+protected:
+  // The calling thread's innermost hook, or null. Implementations call it
+  // from get() once the request has a connection; one that assigns
+  // connections on another thread copies it first.
+  static const std::function<void()> *connection_hook();
+};
+
+// Default transport: one httplib::SSLClient (blocking sockets). Trusts the
+// CA store of `tls`, so clients sharing a TlsContext parse the bundle once.
+//
+// Connections are kept alive between requests. One idle for longer than
+// set_max_idle() is closed before the next request rather than risking a
+// server-side close mid-send, and a request that fails on a reused
+// connection before any response arrived, and before the timeout ran out, is
+// resent once right away on a fresh one (GETs are idempotent), without going
+// through Client's backoff.
+//
+// httplib connects to the first address the resolver returns. To avoid
+// hanging on a broken address family, the transport races the host's
+// addresses (see race_connect) and pins httplib to the winner; it races again
+// when the pinned address fails to connect and, between connections, every
+// few minutes to follow DNS changes. After a race with no winner it backs off
+// and lets httplib connect on its own for a while.
+class HttplibTransport : public Transport {
+public:
+  HttplibTransport(const std::string &host, int port,
+                   std::shared_ptr<TlsContext> tls = TlsContext::shared());
+
+  // On by default. When off, httplib resolves and connects on its own.
+  void set_happy_eyeballs(bool enabled);
+
+  // Longest a kept-alive connection may sit idle and still be reused
+  // (default 30 s; keep it below the server's keep-alive timeout).
+  void set_max_idle(std::chrono::seconds max_idle);
+
+  httplib::Result get(const std::string &path, const httplib::Params &params,
+                      const httplib::Headers &headers,
+                      httplib::ResponseHandler on_response,
+                      httplib::ContentReceiver on_data) override;
+
+  void set_timeout(std::chrono::seconds timeout) override;
+  void cancel_all() override;
+
+private:
+  void pin_address_locked();
+  httplib::Result send_locked(const std::string &path,
+                              const httplib::Params &params,
+                              const httplib::Headers &headers,
+                              const httplib::ResponseHandler &on_response,
+                              const httplib::ContentReceiver &on_data);
+
+  const std::string host_;
+  const int port_;
+  std::shared_ptr<TlsContext> tls_;
+  // Set without the lock, which get() holds for a whole request; each get()
+  // applies it to httplib before sending.
+  std::atomic<std::chrono::seconds> timeout_{std::chrono::seconds(30)};
+  // Bumped by cancel_all(). A get() that started before the bump fails with
+  // Error::Canceled instead of sending, or resending, its request.
+  std::atomic<uint64_t> cancel_generation_{0};
+  std::mutex mutex_; // guards everything below
+  httplib::SSLClient client_;
+  std::chrono::seconds applied_timeout_{0}; // last timeout given to httplib
+  bool happy_eyeballs_ = true;
+  std::string pinned_; // address httplib is pinned to, empty if none
+  std::chrono::steady_clock::time_point pinned_at_; // time of the last race
+  std::chrono::seconds max_idle_{30};
+  bool connection_open_ = false; // httplib holds a kept-alive socket
+  std::chrono::steady_clock::time_point last_used_;
+};
+
+} // namespace nexusmods
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "nexusmods/projection.h"
+#include "rapidjson/document.h"
+
+namespace nexusmods {
+
+// Typed views of the v1 API payloads, holding the fields the library's own
+// consumers (exporters, indexes, stats) work with. Long free text such as
+// the HTML description is deliberately left out; use the Document for it.
+
+struct Mod {
+  int64_t mod_id = 0;
+  int64_t game_id = 0;
+  std::string domain_name;
+  std::string name;
+  std::string summary;
+  std::string version;
+  std::string author;
+  std::string uploaded_by;
+  std::string picture_url;
+  std::string status;
+  int64_t category_id = 0;
+  int64_t downloads = 0;
+  int64_t unique_downloads = 0;
+  int64_t endorsement_count = 0;
+  int64_t created_timestamp = 0;
+  int64_t updated_timestamp = 0;
+  bool contains_adult_content = false;
+  bool available = false;
+
+  // nullopt if `v` isn't a mod object (e.g. an error document).
+  static std::optional<Mod> from_json(const rapidjson::Value &v);
+  // Projection decoding exactly the fields from_json reads.
+  static const FieldProjection &projection();
+};
+
+struct ModFile {
+  int64_t file_id = 0;
+  int64_t mod_id = 0; // not part of the payload; filled from the request
+  int64_t game_id = 0; // likewise; file ids are only unique per game
+  std::string name;
+  std::string version;
+  std::string mod_version;
+  std::string category_name; // "MAIN", "OPTIONAL", "OLD_VERSION", ...
+  std::string file_name;
+  int64_t category_id = 0;
+  int64_t size_in_bytes = 0;
+  int64_t uploaded_timestamp = 0;
+  bool is_primary = false;
+
+  static std::optional<ModFile> from_json(const rapidjson::Value &v,
+                                          int64_t mod_id);
+  // All entries of a list_mod_files() response.
+  static std::vector<ModFile> list_from_json(const rapidjson::Value &doc,
+                                             int64_t mod_id);
+  static const FieldProjection &projection();
+};
+
+struct GameCategory {
+  int64_t category_id = 0;
+  int64_t parent_category = 0; // 0 for top-level categories
+  std::string name;
+};
+
+struct Game {
+  int64_t id = 0;
+  std::string name;
+  std::string domain_name;
+  std::string genre;
+  int64_t mods = 0;
+  int64_t downloads = 0;
+  int64_t file_count = 0;
+  std::vector<GameCategory> categories;
+
+  static std::optional<Game> from_json(const rapidjson::Value &v);
+  // All entries of a get_games() response.
+  static std::vector<Game> list_from_json(const rapidjson::Value &doc);
+};
+
+} // namespace nexusmods
@@ -0,0 +1,62 @@
+#pragma once
+
+// Only available when the library is configured with
+// -DNEXUSMODS_WITH_IO_URING=ON (Linux 5.19+, liburing >= 2.2).
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "nexusmods/transport.h"
+
+namespace nexusmods {
+
+// HTTPS transport driven by a single io_uring event loop. Connects, sends
+// and receives for every in-flight request are queued as submissions and
+// reaped in batches, so thousands of concurrent requests cost a handful of
+// syscalls per loop turn rather than one per socket read or write. TLS runs
+// in userspace through OpenSSL memory BIOs on top of the ring. Connections
+// are kept alive and reused; a reused connection that turns out to have been
+// closed by the server is replaced and the request resent once. A connect
+// that fails or stalls moves on to the host's next address, and the host is
+// looked up again every few minutes and after every address has failed.
+//
+// Callers block in get() as with HttplibTransport, but the response
+// handlers and the caller's ConnectionHook run on the loop thread and must
+// not block.
+//
+//   client.set_transport(std::make_shared<UringTransport>("api.nexusmods.com", 443));
+class UringTransport : public Transport {
+public:
+  struct Options {
+    unsigned queue_depth = 256;
+    size_t max_connections = 64; // further requests wait for a free one
+    // CA store, SSL_CTX and session cache (resumes TLS sessions on reconnect).
+    std::shared_ptr<TlsContext> tls = TlsContext::shared();
+  };
+
+  UringTransport(const std::string &host, int port);
+  UringTransport(const std::string &host, int port, Options options);
+  ~UringTransport() override; // fails whatever is still in flight
+
+  UringTransport(const UringTransport &) = delete;
+  UringTransport &operator=(const UringTransport &) = delete;
+
+  // False if the ring or the TLS context couldn't be set up; every request
+  // then fails with Error::Connection.
+  bool is_valid() const;
+
+  httplib::Result get(const std::string &path, const httplib::Params &params,
+                      const httplib::Headers &headers,
+                      httplib::ResponseHandler on_response,
+                      httplib::ContentReceiver on_data) override;
+
+  void set_timeout(std::chrono::seconds timeout) override;
+  void cancel_all() override;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace nexusmods
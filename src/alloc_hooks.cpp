@@ -0,0 +1,93 @@
+// Replacement global operator new/delete that count allocations per thread
+// for CallMetrics. Only built with -DNEXUSMODS_WITH_ALLOC_HOOKS=ON, since it
+// replaces the allocator entry points for the whole program.
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace nexusmods {
+
+namespace {
+
+// Zero-initialized, so no TLS constructor runs inside operator new.
+thread_local uint64_t tl_count = 0;
+thread_local uint64_t tl_bytes = 0;
+
+void *counted_alloc(std::size_t size) {
+  ++tl_count;
+  tl_bytes += size;
+  return std::malloc(size ? size : 1);
+}
+
+void *counted_alloc(std::size_t size, std::align_val_t align) {
+  ++tl_count;
+  tl_bytes += size;
+  std::size_t a = static_cast<std::size_t>(align);
+  std::size_t rounded = (size + a - 1) / a * a;
+  return std::aligned_alloc(a, rounded ? rounded : a);
+}
+
+} // namespace
+
+void thread_alloc_counts(uint64_t &count, uint64_t &bytes) {
+  count = tl_count;
+  bytes = tl_bytes;
+}
+
+} // namespace nexusmods
+
+using nexusmods::counted_alloc;
+
+void *operator new(std::size_t size) {
+  if (void *p = counted_alloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+  if (void *p = counted_alloc(size, align))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+  return ::operator new(size, align);
+}
+
+void *operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t &) noexcept {
+  return counted_alloc(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t &) noexcept {
+  return counted_alloc(size, align);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
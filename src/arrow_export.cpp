@@ -0,0 +1,253 @@
+#include "nexusmods/arrow_export.h"
+
+#include <type_traits>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include <parquet/arrow/writer.h>
+
+#include "record_columns.h"
+
+namespace nexusmods {
+
+namespace {
+
+template <typename R>
+std::shared_ptr<arrow::DataType> arrow_type(const RecordColumn<R> &c) {
+  if (holds_field<std::string>(c))
+    return arrow::utf8();
+  if (holds_field<bool>(c))
+    return arrow::boolean();
+  return arrow::int64();
+}
+
+template <typename R>
+arrow::Status append_value(arrow::ArrayBuilder &b, const RecordColumn<R> &c,
+                           const R &row) {
+  return visit_field(c, row, [&](const auto &v) {
+    using T = std::decay_t<decltype(v)>;
+    if constexpr (std::is_same_v<T, std::string>)
+      return static_cast<arrow::StringBuilder &>(b).Append(v);
+    else if constexpr (std::is_same_v<T, bool>)
+      return static_cast<arrow::BooleanBuilder &>(b).Append(v);
+    else
+      return static_cast<arrow::Int64Builder &>(b).Append(v);
+  });
+}
+
+const RecordColumns<Mod> &mod_columns() {
+  static const RecordColumns<Mod> cols = {
+      column("mod_id", &Mod::mod_id),
+      column("game_id", &Mod::game_id),
+      column("domain_name", &Mod::domain_name),
+      column("name", &Mod::name),
+      column("summary", &Mod::summary),
+      column("version", &Mod::version),
+      column("author", &Mod::author),
+      column("uploaded_by", &Mod::uploaded_by),
+      column("status", &Mod::status),
+      column("category_id", &Mod::category_id),
+      column("downloads", &Mod::downloads),
+      column("unique_downloads", &Mod::unique_downloads),
+      column("endorsement_count", &Mod::endorsement_count),
+      column("created_timestamp", &Mod::created_timestamp),
+      column("updated_timestamp", &Mod::updated_timestamp),
+      column("contains_adult_content", &Mod::contains_adult_content),
+      column("available", &Mod::available),
+  };
+  return cols;
+}
+
+const RecordColumns<ModFile> &file_columns() {
+  static const RecordColumns<ModFile> cols = {
+      column("file_id", &ModFile::file_id),
+      column("mod_id", &ModFile::mod_id),
+      column("game_id", &ModFile::game_id),
+      column("name", &ModFile::name),
+      column("version", &ModFile::version),
+      column("mod_version", &ModFile::mod_version),
+      column("category_name", &ModFile::category_name),
+      column("file_name", &ModFile::file_name),
+      column("category_id", &ModFile::category_id),
+      column("size_in_bytes", &ModFile::size_in_bytes),
+      column("uploaded_timestamp", &ModFile::uploaded_timestamp),
+      column("is_primary", &ModFile::is_primary),
+  };
+  return cols;
+}
+
+template <typename R>
+std::shared_ptr<arrow::Schema>
+make_schema(const RecordColumns<R> &cols) {
+  arrow::FieldVector fields;
+  fields.reserve(cols.size());
+  for (const auto &c : cols)
+    fields.push_back(arrow::field(c.name, arrow_type(c), /*nullable=*/false));
+  return arrow::schema(std::move(fields));
+}
+
+} // namespace
+
+struct CatalogExporter::Impl {
+  Table table = Table::Mods;
+  Options options;
+  std::shared_ptr<arrow::Schema> schema;
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+  std::shared_ptr<arrow::io::FileOutputStream> sink;
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc;
+  std::unique_ptr<parquet::arrow::FileWriter> parquet;
+  size_t pending = 0;
+  size_t written = 0;
+  std::string error;
+
+  bool is_open() const { return sink != nullptr; }
+
+  bool fail(const arrow::Status &st) {
+    error = st.ToString();
+    return false;
+  }
+
+  arrow::Status open(const std::string &path) {
+    schema = table == Table::Mods ? make_schema(mod_columns())
+                                  : make_schema(file_columns());
+    builders.clear();
+    for (const auto &f : schema->fields()) {
+      ARROW_ASSIGN_OR_RAISE(auto b, arrow::MakeBuilder(f->type()));
+      ARROW_RETURN_NOT_OK(b->Reserve(options.batch_rows));
+      builders.push_back(std::move(b));
+    }
+
+    ARROW_ASSIGN_OR_RAISE(sink, arrow::io::FileOutputStream::Open(path));
+    if (options.format == Format::ArrowIpc) {
+      ARROW_ASSIGN_OR_RAISE(ipc, arrow::ipc::MakeStreamWriter(sink, schema));
+    } else {
+      // Row groups are cut in flush(); the cap only stops a large batch
+      // from being split at the default of 1Mi rows.
+      auto props = parquet::WriterProperties::Builder()
+                       .max_row_group_length(
+                           static_cast<int64_t>(options.batch_rows))
+                       ->build();
+      ARROW_ASSIGN_OR_RAISE(
+          parquet, parquet::arrow::FileWriter::Open(
+                       *schema, arrow::default_memory_pool(), sink, props,
+                       parquet::default_arrow_writer_properties()));
+    }
+    return arrow::Status::OK();
+  }
+
+  template <typename R>
+  arrow::Status append(const RecordColumns<R> &cols, const R &row) {
+    for (size_t i = 0; i < cols.size(); ++i)
+      ARROW_RETURN_NOT_OK(append_value(*builders[i], cols[i], row));
+    if (++pending >= options.batch_rows)
+      return flush();
+    return arrow::Status::OK();
+  }
+
+  arrow::Status flush() {
+    if (pending == 0)
+      return arrow::Status::OK();
+    arrow::ArrayVector arrays;
+    arrays.reserve(builders.size());
+    for (auto &b : builders) {
+      std::shared_ptr<arrow::Array> a;
+      ARROW_RETURN_NOT_OK(b->Finish(&a));
+      ARROW_RETURN_NOT_OK(b->Reserve(options.batch_rows));
+      arrays.push_back(std::move(a));
+    }
+    auto batch = arrow::RecordBatch::Make(
+        schema, static_cast<int64_t>(pending), std::move(arrays));
+    if (ipc) {
+      ARROW_RETURN_NOT_OK(ipc->WriteRecordBatch(*batch));
+    } else {
+      // WriteRecordBatch appends to the open buffered row group; start a new
+      // one so the previous batch is encoded and written out now.
+      ARROW_RETURN_NOT_OK(parquet->NewBufferedRowGroup());
+      ARROW_RETURN_NOT_OK(parquet->WriteRecordBatch(*batch));
+    }
+    written += pending;
+    pending = 0;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status close() {
+    ARROW_RETURN_NOT_OK(flush());
+    if (ipc)
+      ARROW_RETURN_NOT_OK(ipc->Close());
+    if (parquet)
+      ARROW_RETURN_NOT_OK(parquet->Close());
+    ARROW_RETURN_NOT_OK(sink->Close());
+    ipc.reset();
+    parquet.reset();
+    sink.reset();
+    return arrow::Status::OK();
+  }
+};
+
+CatalogExporter::CatalogExporter() : impl_(std::make_unique<Impl>()) {}
+
+CatalogExporter::~CatalogExporter() {
+  if (impl_->is_open())
+    close();
+}
+
+bool CatalogExporter::open(const std::string &path, Table table) {
+  return open(path, table, Options());
+}
+
+bool CatalogExporter::open(const std::string &path, Table table,
+                           Options options) {
+  if (impl_->is_open() && !close())
+    return false;
+  if (options.batch_rows == 0)
+    options.batch_rows = 1;
+  impl_->table = table;
+  impl_->options = options;
+  impl_->pending = 0;
+  impl_->written = 0;
+  auto st = impl_->open(path);
+  if (!st.ok()) {
+    impl_->sink.reset();
+    return impl_->fail(st);
+  }
+  return true;
+}
+
+bool CatalogExporter::append(const Mod &mod) {
+  if (!impl_->is_open() || impl_->table != Table::Mods) {
+    impl_->error = "exporter is not open for mods";
+    return false;
+  }
+  auto st = impl_->append(mod_columns(), mod);
+  return st.ok() || impl_->fail(st);
+}
+
+bool CatalogExporter::append(const ModFile &file) {
+  if (!impl_->is_open() || impl_->table != Table::Files) {
+    impl_->error = "exporter is not open for files";
+    return false;
+  }
+  auto st = impl_->append(file_columns(), file);
+  return st.ok() || impl_->fail(st);
+}
+
+bool CatalogExporter::close() {
+  if (!impl_->is_open())
+    return true;
+  auto st = impl_->close();
+  if (!st.ok()) {
+    // The file is unusable either way; don't retry from the destructor.
+    impl_->ipc.reset();
+    impl_->parquet.reset();
+    impl_->sink.reset();
+    return impl_->fail(st);
+  }
+  return true;
+}
+
+size_t CatalogExporter::rows_written() const { return impl_->written; }
+
+const std::string &CatalogExporter::last_error() const { return impl_->error; }
+
+} // namespace nexusmods
@@ -0,0 +1,478 @@
+#include "nexusmods/asset_fetcher.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+
+#include <openssl/evp.h>
+
+#include "httplib.h"
+#include "nexusmods/tls_context.h"
+
+namespace nexusmods {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string sha256_hex(std::string_view data) {
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int len = 0;
+  EVP_Digest(data.data(), data.size(), digest, &len, EVP_sha256(), nullptr);
+  static const char hex[] = "0123456789abcdef";
+  std::string out;
+  out.reserve(len * 2);
+  for (unsigned int i = 0; i < len; ++i) {
+    out += hex[digest[i] >> 4];
+    out += hex[digest[i] & 0xf];
+  }
+  return out;
+}
+
+struct Url {
+  std::string host;
+  int port = 443;
+  std::string path;
+};
+
+std::optional<Url> parse_https_url(const std::string &url) {
+  constexpr std::string_view scheme = "https://";
+  if (url.compare(0, scheme.size(), scheme) != 0)
+    return std::nullopt;
+  auto slash = url.find('/', scheme.size());
+  Url out;
+  out.host = url.substr(scheme.size(), slash - scheme.size());
+  out.path = slash == std::string::npos ? "/" : url.substr(slash);
+  auto colon = out.host.rfind(':');
+  if (colon != std::string::npos) {
+    try {
+      out.port = std::stoi(out.host.substr(colon + 1));
+    } catch (...) {
+      return std::nullopt;
+    }
+    out.host.resize(colon);
+  }
+  if (out.host.empty())
+    return std::nullopt;
+  return out;
+}
+
+// What the cache remembers about a URL.
+struct Entry {
+  std::string hash; // of the body
+  std::string content_type;
+  std::string etag;
+  std::string last_modified;
+  int64_t expires = 0; // unix seconds
+};
+
+// One field per line, in declaration order.
+std::optional<Entry> read_entry(const fs::path &path) {
+  std::ifstream in(path);
+  Entry e;
+  std::string expires;
+  if (!std::getline(in, e.hash) || !std::getline(in, e.content_type) ||
+      !std::getline(in, e.etag) || !std::getline(in, e.last_modified) ||
+      !std::getline(in, expires) || e.hash.empty())
+    return std::nullopt;
+  try {
+    e.expires = std::stoll(expires);
+  } catch (...) {
+    return std::nullopt;
+  }
+  return e;
+}
+
+std::optional<std::string> read_file(const fs::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return std::nullopt;
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  return std::move(ss).str();
+}
+
+// Writes under a temporary name and renames it into place, so readers never
+// see a partial file.
+bool write_file(const fs::path &path, std::string_view data) {
+  static std::atomic<uint64_t> counter{0};
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  fs::path tmp = path;
+  tmp += ".tmp" + std::to_string(::getpid()) + "." +
+         std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out) {
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+bool write_entry(const fs::path &path, const Entry &e) {
+  // Header values can't hold newlines, so fields can't spill into the next.
+  return write_file(path, e.hash + "\n" + e.content_type + "\n" + e.etag +
+                              "\n" + e.last_modified + "\n" +
+                              std::to_string(e.expires) + "\n");
+}
+
+// Marks a file as recently used, for prune().
+void touch(const fs::path &path) {
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+int64_t unix_now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+constexpr int kMaxRedirects = 5;
+
+bool is_redirect(int status) {
+  return status == 301 || status == 302 || status == 303 || status == 307 ||
+         status == 308;
+}
+
+// Where a redirect from `from` points, if that is an https URL.
+std::optional<Url> redirect_target(const Url &from,
+                                   const std::string &location) {
+  if (location.compare(0, 2, "//") == 0)
+    return parse_https_url("https:" + location);
+  if (!location.empty() && location[0] == '/') {
+    Url out = from;
+    out.path = location;
+    return out;
+  }
+  return parse_https_url(location);
+}
+
+bool no_store(const httplib::Response &res) {
+  auto it = res.headers.find("Cache-Control");
+  return it != res.headers.end() &&
+         it->second.find("no-store") != std::string::npos;
+}
+
+// Cache-Control max-age in seconds; 0 for no-cache and no-store.
+std::optional<int64_t> max_age(const httplib::Response &res) {
+  auto it = res.headers.find("Cache-Control");
+  if (it == res.headers.end())
+    return std::nullopt;
+  const std::string &v = it->second;
+  if (v.find("no-cache") != std::string::npos ||
+      v.find("no-store") != std::string::npos)
+    return 0;
+  auto at = v.find("max-age=");
+  if (at == std::string::npos)
+    return std::nullopt;
+  try {
+    return std::max<int64_t>(std::stoll(v.substr(at + 8)), 0);
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+} // namespace
+
+// Kept per worker so requests never wait for a client another worker holds.
+class AssetFetcher::Connections {
+public:
+  explicit Connections(const Options &options) : options_(options) {}
+
+  httplib::SSLClient &get(const std::string &host, int port) {
+    auto &client = clients_[{host, port}];
+    if (client)
+      return *client;
+    client = std::make_unique<httplib::SSLClient>(host, port);
+    client->set_keep_alive(true);
+    // Redirects are followed by load(), which refuses to leave https.
+    client->set_follow_location(false);
+    client->set_connection_timeout(options_.timeout);
+    client->set_read_timeout(options_.timeout);
+    if (options_.tls)
+      options_.tls->configure(*client, host);
+    return *client;
+  }
+
+private:
+  const Options &options_;
+  std::map<std::pair<std::string, int>, std::unique_ptr<httplib::SSLClient>>
+      clients_;
+};
+
+bool AssetFetcher::Key::operator<(const Key &o) const {
+  return std::tie(url, width, height) < std::tie(o.url, o.width, o.height);
+}
+
+AssetFetcher::AssetFetcher(Options options) : options_(std::move(options)) {
+  size_t workers = std::max<size_t>(options_.max_parallel, 1);
+  workers_.reserve(workers);
+  for (size_t i = 0; i < workers; ++i)
+    workers_.emplace_back([this] { work(); });
+}
+
+AssetFetcher::~AssetFetcher() {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &t : workers_)
+    t.join();
+}
+
+std::future<std::optional<Asset>>
+AssetFetcher::fetch_async(const std::string &url) {
+  return fetch_async(url, ThumbnailSize());
+}
+
+std::future<std::optional<Asset>>
+AssetFetcher::fetch_async(const std::string &url, ThumbnailSize size) {
+  Promise promise;
+  auto result = promise.get_future();
+  Key key{url, std::max(size.width, 0), std::max(size.height, 0)};
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    auto &waiters = pending_[key];
+    if (waiters.empty())
+      jobs_.push_back(key);
+    else
+      ++stats_.shared;
+    waiters.push_back(std::move(promise));
+  }
+  cv_.notify_one();
+  return result;
+}
+
+std::optional<Asset> AssetFetcher::fetch(const std::string &url) {
+  return fetch_async(url).get();
+}
+
+std::optional<Asset> AssetFetcher::fetch(const std::string &url,
+                                         ThumbnailSize size) {
+  return fetch_async(url, size).get();
+}
+
+AssetFetcher::Stats AssetFetcher::stats() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return stats_;
+}
+
+void AssetFetcher::work() {
+  Connections connections(options_);
+  std::unique_lock<std::mutex> l(mutex_);
+  for (;;) {
+    cv_.wait(l, [&] { return stop_ || !jobs_.empty(); });
+    if (jobs_.empty())
+      return;
+    Key key = std::move(jobs_.front());
+    jobs_.pop_front();
+    l.unlock();
+
+    std::optional<Asset> asset;
+    std::exception_ptr error;
+    try {
+      asset = load(key, connections);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    l.lock();
+    // Waiters that arrived during the fetch are answered too.
+    auto it = pending_.find(key);
+    std::vector<Promise> waiters = std::move(it->second);
+    pending_.erase(it);
+    if (!asset)
+      ++stats_.failed;
+    else if (asset->source == Asset::Source::Cache)
+      ++stats_.hits;
+    else if (asset->source == Asset::Source::Revalidated)
+      ++stats_.revalidated;
+    else if (asset->source == Asset::Source::Downloaded)
+      ++stats_.downloaded;
+    else
+      ++stats_.stale;
+    l.unlock();
+
+    for (auto &w : waiters) {
+      if (error)
+        w.set_exception(error);
+      else
+        w.set_value(asset);
+    }
+
+    l.lock();
+  }
+}
+
+std::optional<Asset> AssetFetcher::load(const Key &key,
+                                        Connections &connections) {
+  const fs::path dir = options_.cache_dir;
+  auto object_path = [&](const std::string &hash) {
+    return dir / "objects" / hash.substr(0, 2) / hash;
+  };
+  const fs::path entry_path = dir / "urls" / sha256_hex(key.url);
+
+  std::optional<Entry> entry = read_entry(entry_path);
+  std::error_code ec;
+  if (entry && !fs::exists(object_path(entry->hash), ec))
+    entry.reset(); // pruned
+  const int64_t now = unix_now();
+
+  Asset asset;
+  if (entry && now < entry->expires) {
+    asset.source = Asset::Source::Cache;
+  } else {
+    std::optional<Url> url = parse_https_url(key.url);
+    if (!url)
+      return std::nullopt;
+    httplib::Headers headers = {{"User-Agent", options_.user_agent}};
+    if (entry && !entry->etag.empty())
+      headers.emplace("If-None-Match", entry->etag);
+    if (entry && !entry->last_modified.empty())
+      headers.emplace("If-Modified-Since", entry->last_modified);
+
+    httplib::Result res;
+    for (int hop = 0;; ++hop) {
+      res = connections.get(url->host, url->port).Get(url->path, headers);
+      if (!res || !is_redirect(res->status) || hop == kMaxRedirects)
+        break;
+      // Anything but https ends the chain; the 3xx then counts as a failure.
+      std::optional<Url> next =
+          redirect_target(*url, res->get_header_value("Location"));
+      if (!next)
+        break;
+      url = std::move(next);
+    }
+    auto lifetime = [&] {
+      return max_age(*res).value_or(options_.max_age.count());
+    };
+    if (res && res->status == 304 && entry) {
+      entry->expires = now + lifetime();
+      write_entry(entry_path, *entry);
+      asset.source = Asset::Source::Revalidated;
+    } else if (res && res->status == 200 && no_store(*res)) {
+      // Served from memory only, and any earlier copy is forgotten.
+      fs::remove(entry_path, ec);
+      asset.source = Asset::Source::Downloaded;
+      asset.content_type = res->get_header_value("Content-Type");
+      asset.data = std::move(res->body);
+      ThumbnailSize size{key.width, key.height};
+      if ((size.width > 0 || size.height > 0) && options_.resizer) {
+        if (auto scaled = options_.resizer(asset.data, size)) {
+          asset.data = std::move(*scaled);
+          std::lock_guard<std::mutex> l(mutex_);
+          ++stats_.resized;
+        }
+      }
+      return asset;
+    } else if (res && res->status == 200) {
+      Entry fresh;
+      fresh.hash = sha256_hex(res->body);
+      fresh.content_type = res->get_header_value("Content-Type");
+      fresh.etag = res->get_header_value("ETag");
+      fresh.last_modified = res->get_header_value("Last-Modified");
+      fresh.expires = now + lifetime();
+      fs::path object = object_path(fresh.hash);
+      if (!fs::exists(object, ec) && !write_file(object, res->body))
+        return std::nullopt;
+      write_entry(entry_path, fresh);
+      entry = std::move(fresh);
+      asset.source = Asset::Source::Downloaded;
+    } else if (entry) {
+      asset.source = Asset::Source::Stale;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  asset.path = object_path(entry->hash).string();
+  asset.content_type = entry->content_type;
+  touch(asset.path);
+  if (key.width <= 0 && key.height <= 0)
+    return asset;
+  return thumbnail(std::move(asset), {key.width, key.height});
+}
+
+std::optional<Asset> AssetFetcher::thumbnail(Asset original,
+                                             ThumbnailSize size) {
+  if (!options_.resizer)
+    return original;
+  fs::path source = original.path;
+  fs::path path = fs::path(options_.cache_dir) / "thumbs" /
+                  (source.filename().string() + "-" +
+                   std::to_string(size.width) + "x" +
+                   std::to_string(size.height));
+  std::error_code ec;
+  if (!fs::exists(path, ec)) {
+    std::optional<std::string> image = read_file(source);
+    if (!image)
+      return std::nullopt;
+    std::optional<std::string> scaled = options_.resizer(*image, size);
+    if (!scaled || !write_file(path, *scaled))
+      return original; // full size beats nothing
+    std::lock_guard<std::mutex> l(mutex_);
+    ++stats_.resized;
+  } else {
+    touch(path);
+  }
+  original.path = path.string();
+  return original;
+}
+
+uint64_t AssetFetcher::prune(uint64_t max_bytes) {
+  struct File {
+    fs::path path;
+    fs::file_time_type used;
+    uint64_t size;
+  };
+  std::vector<File> files;
+  uint64_t total = 0;
+  std::error_code ec;
+  for (const char *sub : {"objects", "thumbs"}) {
+    fs::path dir = fs::path(options_.cache_dir) / sub;
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+      if (!it->is_regular_file(ec) ||
+          it->path().filename().string().find(".tmp") != std::string::npos)
+        continue;
+      File f{it->path(), it->last_write_time(ec), it->file_size(ec)};
+      if (ec) {
+        ec.clear();
+        continue;
+      }
+      total += f.size;
+      files.push_back(std::move(f));
+    }
+    ec.clear();
+  }
+
+  std::sort(files.begin(), files.end(),
+            [](const File &a, const File &b) { return a.used < b.used; });
+  uint64_t freed = 0;
+  for (const File &f : files) {
+    if (total - freed <= max_bytes)
+      break;
+    // URL entries pointing at a removed body become misses.
+    if (fs::remove(f.path, ec))
+      freed += f.size;
+  }
+  return freed;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,148 @@
+#include "nexusmods/buffer_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "trace.h"
+
+namespace nexusmods {
+
+namespace {
+
+constexpr size_t kMinShift = 12; // 4 KiB
+constexpr size_t kMaxShift = 24; // 16 MiB
+constexpr size_t kClasses = kMaxShift - kMinShift + 1;
+
+size_t class_size(size_t cls) { return size_t(1) << (cls + kMinShift); }
+
+// Smallest class able to hold `n` bytes.
+size_t class_for_request(size_t n) {
+  size_t cls = 0;
+  while (cls + 1 < kClasses && class_size(cls) < n)
+    ++cls;
+  return cls;
+}
+
+// Largest class whose size fits in `capacity`.
+size_t class_for_capacity(size_t capacity) {
+  size_t cls = 0;
+  while (cls + 1 < kClasses && class_size(cls + 1) <= capacity)
+    ++cls;
+  return cls;
+}
+
+} // namespace
+
+struct BufferPool::Impl {
+  mutable std::mutex mutex;
+  std::array<std::vector<std::string>, kClasses> free;
+  size_t max_pooled_bytes;
+  Stats stats;
+  std::shared_ptr<MemoryAccountant> accountant;
+  MemoryAccountant::SubsystemId subsystem = 0;
+
+  void trim(size_t bytes) {
+    size_t dropped = 0;
+    {
+      std::lock_guard<std::mutex> l(mutex);
+      for (size_t cls = kClasses; cls-- > 0 && dropped < bytes;) {
+        auto &list = free[cls];
+        while (!list.empty() && dropped < bytes) {
+          dropped += list.back().capacity();
+          --stats.pooled_buffers;
+          list.pop_back();
+        }
+      }
+      stats.pooled_bytes -= dropped;
+    }
+    if (accountant && dropped)
+      accountant->release(subsystem, dropped);
+  }
+};
+
+BufferPool::BufferPool(size_t max_pooled_bytes,
+                       std::shared_ptr<MemoryAccountant> accountant)
+    : impl_(std::make_shared<Impl>()) {
+  impl_->max_pooled_bytes = max_pooled_bytes;
+  impl_->accountant = std::move(accountant);
+  if (impl_->accountant) {
+    // The accountant may outlive us; only reach the pool while it exists.
+    std::weak_ptr<Impl> weak = impl_;
+    impl_->subsystem = impl_->accountant->register_subsystem(
+        "buffer_pool", [weak](size_t bytes) {
+          if (auto impl = weak.lock())
+            impl->trim(bytes);
+        });
+  }
+}
+
+BufferPool::~BufferPool() { impl_->trim(static_cast<size_t>(-1)); }
+
+std::string BufferPool::acquire(size_t size_hint) {
+  size_t cls = class_for_request(size_hint);
+  std::string out;
+  bool hit = false;
+  {
+    std::lock_guard<std::mutex> l(impl_->mutex);
+    // Accept one class up if the exact one is empty; anything larger would
+    // waste more than it saves.
+    for (size_t c = cls; c < kClasses && c <= cls + 1; ++c) {
+      auto &list = impl_->free[c];
+      if (!list.empty()) {
+        out = std::move(list.back());
+        list.pop_back();
+        --impl_->stats.pooled_buffers;
+        impl_->stats.pooled_bytes -= out.capacity();
+        ++impl_->stats.hits;
+        hit = true;
+        break;
+      }
+    }
+    if (!hit)
+      ++impl_->stats.misses;
+  }
+  if (hit) {
+    NEXUSMODS_TRACE1(pool_hit, size_hint);
+    if (impl_->accountant)
+      impl_->accountant->release(impl_->subsystem, out.capacity());
+    out.reserve(size_hint);
+    return out;
+  }
+  NEXUSMODS_TRACE1(pool_miss, size_hint);
+  out.reserve(std::max(size_hint, class_size(cls)));
+  return out;
+}
+
+void BufferPool::release(std::string &&buffer) {
+  size_t capacity = buffer.capacity();
+  if (capacity < class_size(0) || capacity > 2 * class_size(kClasses - 1))
+    return;
+  if (impl_->accountant &&
+      !impl_->accountant->try_add(impl_->subsystem, capacity))
+    return;
+
+  buffer.clear();
+  {
+    std::lock_guard<std::mutex> l(impl_->mutex);
+    auto &list = impl_->free[class_for_capacity(capacity)];
+    if (impl_->stats.pooled_bytes + capacity <= impl_->max_pooled_bytes) {
+      list.push_back(std::move(buffer));
+      ++impl_->stats.pooled_buffers;
+      impl_->stats.pooled_bytes += capacity;
+      return;
+    }
+  }
+  if (impl_->accountant)
+    impl_->accountant->release(impl_->subsystem, capacity);
+}
+
+void BufferPool::trim(size_t bytes) { impl_->trim(bytes); }
+
+BufferPool::Stats BufferPool::stats() const {
+  std::lock_guard<std::mutex> l(impl_->mutex);
+  return impl_->stats;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,152 @@
+#include "nexusmods/call_metrics.h"
+
+#include <algorithm>
+#include <ctime>
+
+namespace nexusmods {
+
+#ifdef NEXUSMODS_WITH_ALLOC_HOOKS
+// alloc_hooks.cpp; referencing it also pulls the operator new replacements
+// out of the static library.
+void thread_alloc_counts(uint64_t &count, uint64_t &bytes);
+#endif
+
+ThreadUsage ThreadUsage::now() {
+  ThreadUsage u;
+  timespec ts{};
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    u.cpu_ns = int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#ifdef NEXUSMODS_WITH_ALLOC_HOOKS
+  thread_alloc_counts(u.allocations, u.allocated_bytes);
+#endif
+  return u;
+}
+
+bool ThreadUsage::tracks_allocations() {
+#ifdef NEXUSMODS_WITH_ALLOC_HOOKS
+  return true;
+#else
+  return false;
+#endif
+}
+
+const char *to_string(CallMetrics::Phase phase) {
+  switch (phase) {
+  case CallMetrics::Phase::Headers:
+    return "headers";
+  case CallMetrics::Phase::Transport:
+    return "transport";
+  case CallMetrics::Phase::Parse:
+    return "parse";
+  }
+  return "unknown";
+}
+
+CallMetrics::Scope::Scope(CallMetrics *metrics, std::string_view path,
+                          Phase phase)
+    : metrics_(metrics), path_(path), phase_(phase) {
+  if (!metrics_)
+    return;
+  wall_ = std::chrono::steady_clock::now();
+  start_ = ThreadUsage::now();
+}
+
+void CallMetrics::Scope::finish() {
+  if (!metrics_)
+    return;
+  ThreadUsage end = ThreadUsage::now();
+  Cost c;
+  c.samples = 1;
+  c.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - wall_)
+                  .count();
+  c.cpu_ns = end.cpu_ns - start_.cpu_ns;
+  c.allocations = end.allocations - start_.allocations;
+  c.allocated_bytes = end.allocated_bytes - start_.allocated_bytes;
+  metrics_->add(path_, phase_, c);
+  metrics_ = nullptr;
+}
+
+// Numeric segments (ignoring an extension) become {id}; the segment after
+// "games" is the game domain.
+std::string CallMetrics::normalize(std::string_view path) {
+  std::string out;
+  out.reserve(path.size());
+  std::string_view prev;
+  size_t pos = 0;
+  while (pos <= path.size()) {
+    size_t slash = path.find('/', pos);
+    if (slash == std::string_view::npos)
+      slash = path.size();
+    std::string_view seg = path.substr(pos, slash - pos);
+    std::string_view stem = seg.substr(0, seg.find('.'));
+    if (prev == "games" && !seg.empty()) {
+      out += "{game}";
+      out += seg.substr(stem.size());
+    } else if (!stem.empty() &&
+               std::all_of(stem.begin(), stem.end(),
+                           [](char ch) { return ch >= '0' && ch <= '9'; })) {
+      out += "{id}";
+      out += seg.substr(stem.size());
+    } else {
+      out += seg;
+    }
+    if (slash < path.size())
+      out += '/';
+    prev = seg;
+    pos = slash + 1;
+  }
+  return out;
+}
+
+CallMetrics::Endpoint &CallMetrics::row_locked(std::string_view path) {
+  std::string key = normalize(path);
+  auto it = rows_.find(key);
+  if (it == rows_.end()) {
+    it = rows_.emplace(key, Endpoint{}).first;
+    it->second.endpoint = std::move(key);
+  }
+  return it->second;
+}
+
+void CallMetrics::add(std::string_view path, Phase phase, const Cost &cost) {
+  std::lock_guard<std::mutex> l(mutex_);
+  Cost &c = row_locked(path).phases[static_cast<size_t>(phase)];
+  c.samples += cost.samples;
+  c.wall_ns += cost.wall_ns;
+  c.cpu_ns += cost.cpu_ns;
+  c.allocations += cost.allocations;
+  c.allocated_bytes += cost.allocated_bytes;
+}
+
+void CallMetrics::count_call(std::string_view path) {
+  std::lock_guard<std::mutex> l(mutex_);
+  ++row_locked(path).calls;
+}
+
+std::vector<CallMetrics::Endpoint> CallMetrics::snapshot() const {
+  std::vector<Endpoint> out;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    out.reserve(rows_.size());
+    for (const auto &[key, row] : rows_)
+      out.push_back(row);
+  }
+  auto cpu = [](const Endpoint &e) {
+    int64_t total = 0;
+    for (const auto &p : e.phases)
+      total += p.cpu_ns;
+    return total;
+  };
+  std::sort(out.begin(), out.end(), [&](const Endpoint &a, const Endpoint &b) {
+    return cpu(a) > cpu(b);
+  });
+  return out;
+}
+
+void CallMetrics::reset() {
+  std::lock_guard<std::mutex> l(mutex_);
+  rows_.clear();
+}
+
+} // namespace nexusmods
@@ -0,0 +1,203 @@
+#include "nexusmods/catalog_sync.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "nexusmods/client.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace nexusmods {
+
+namespace {
+
+int64_t int_member(const rapidjson::Value &v, const char *key) {
+  auto it = v.FindMember(key);
+  if (it == v.MemberEnd() || !it->value.IsNumber())
+    return 0;
+  return it->value.IsInt64() ? it->value.GetInt64()
+                             : static_cast<int64_t>(it->value.GetDouble());
+}
+
+std::string to_json(const rapidjson::Value &v) {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  v.Accept(writer);
+  return std::string(sb.GetString(), sb.GetSize());
+}
+
+constexpr std::string_view kStatePrefix = "sync-";
+constexpr std::string_view kStateSuffix = ".state";
+
+std::string state_path(const std::string &dir, const std::string &game) {
+  std::string path = dir + "/";
+  path += kStatePrefix;
+  path += game;
+  path += kStateSuffix;
+  return path;
+}
+
+} // namespace
+
+CatalogSync::CatalogSync(Client &client, ChangeLog &log)
+    : client_(client), log_(log) {}
+
+void CatalogSync::reset() {
+  std::lock_guard<std::mutex> l(mutex_);
+  seen_.clear();
+  loaded_.clear();
+  std::string dir = log_.directory();
+  if (dir.empty())
+    return;
+  std::error_code ec;
+  std::vector<std::filesystem::path> states;
+  for (const auto &e : std::filesystem::directory_iterator(dir, ec)) {
+    const auto name = e.path().filename().string();
+    if (name.starts_with(kStatePrefix) && name.ends_with(kStateSuffix))
+      states.push_back(e.path());
+  }
+  for (const auto &path : states)
+    std::filesystem::remove(path, ec);
+}
+
+CatalogSync::GameState &
+CatalogSync::state_for(const std::string &game_domain_name) {
+  auto &state = seen_[game_domain_name];
+  if (!loaded_.insert(game_domain_name).second)
+    return state;
+  std::string dir = log_.directory();
+  if (dir.empty())
+    return state;
+  // One mod per line: "<mod_id> <mod_activity> <file_update> <game_id>".
+  std::ifstream in(state_path(dir, game_domain_name));
+  int64_t mod_id = 0;
+  Seen seen;
+  while (in >> mod_id >> seen.mod_activity >> seen.file_update >>
+         seen.game_id)
+    state[mod_id] = seen;
+  return state;
+}
+
+void CatalogSync::save(const std::string &game_domain_name,
+                       const GameState &state) {
+  std::string dir = log_.directory();
+  if (dir.empty())
+    return;
+  // Written aside and renamed, so a crash leaves the old state or the new.
+  std::string path = state_path(dir, game_domain_name);
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    for (const auto &[mod_id, seen] : state)
+      out << mod_id << ' ' << seen.mod_activity << ' ' << seen.file_update
+          << ' ' << seen.game_id << '\n';
+    if (!out.flush())
+      return;
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+}
+
+CatalogSync::RunStats CatalogSync::run(const std::string &game_domain_name,
+                                       const std::string &period) {
+  std::lock_guard<std::mutex> l(mutex_);
+  RunStats stats;
+  auto updated =
+      client_.get_updated_mods(game_domain_name, {{"period", period}});
+  if (!updated || !updated->IsArray())
+    return stats;
+  stats.ok = true;
+  stats.candidates = updated->Size();
+
+  auto &seen = state_for(game_domain_name);
+  for (const auto &entry : updated->GetArray()) {
+    int64_t mod_id = int_member(entry, "mod_id");
+    if (mod_id == 0)
+      continue;
+    Seen now{int_member(entry, "latest_mod_activity"),
+             int_member(entry, "latest_file_update")};
+    auto it = seen.find(mod_id);
+    const bool known = it != seen.end();
+    const Seen before = known ? it->second : Seen{};
+    const bool mod_changed = !known || now.mod_activity > before.mod_activity;
+    const bool files_changed = !known || now.file_update > before.file_update;
+    if (!mod_changed && !files_changed)
+      continue;
+
+    // Advanced as each part reaches the log, so a part that fails is
+    // retried next run without repeating the parts that made it.
+    Seen next = before;
+    const std::string id = std::to_string(mod_id);
+    if (mod_changed) {
+      // The mod record is refetched for any activity: file uploads bump its
+      // version and counters too, and it carries the game id.
+      auto doc = client_.get_mod(game_domain_name, id, Mod::projection());
+      auto mod = doc ? Mod::from_json(*doc) : std::nullopt;
+      if (!mod) {
+        ++stats.fetch_failures;
+        continue;
+      }
+      ChangeRecord rec;
+      rec.kind = ChangeRecord::Kind::ModUpdated;
+      rec.game_id = mod->game_id;
+      rec.mod_id = mod_id;
+      rec.timestamp = now.mod_activity;
+      rec.payload = to_json(*doc);
+      if (!log_.append(rec)) {
+        ++stats.fetch_failures;
+        continue;
+      }
+      ++stats.mods_changed;
+      next.mod_activity = now.mod_activity;
+      next.game_id = mod->game_id;
+      seen[mod_id] = next;
+    }
+
+    if (files_changed) {
+      auto files = client_.list_mod_files(game_domain_name, id,
+                                          ModFile::projection());
+      const rapidjson::Value *list = nullptr;
+      if (files && files->IsObject()) {
+        auto m = files->FindMember("files");
+        if (m != files->MemberEnd() && m->value.IsArray())
+          list = &m->value;
+      }
+      if (!list) {
+        ++stats.fetch_failures;
+        continue;
+      }
+      bool complete = true;
+      for (const auto &f : list->GetArray()) {
+        int64_t uploaded = int_member(f, "uploaded_timestamp");
+        if (uploaded <= before.file_update)
+          continue;
+        ChangeRecord frec;
+        frec.kind = ChangeRecord::Kind::FileUpdated;
+        frec.game_id = next.game_id;
+        frec.mod_id = mod_id;
+        frec.file_id = int_member(f, "file_id");
+        frec.timestamp = uploaded;
+        frec.payload = to_json(f);
+        if (!log_.append(frec)) {
+          complete = false;
+          break;
+        }
+        ++stats.files_changed;
+      }
+      if (!complete) {
+        ++stats.fetch_failures;
+        continue;
+      }
+      next.file_update = now.file_update;
+    }
+    seen[mod_id] = next;
+  }
+  // Only claim what is durable in the log.
+  if (log_.flush())
+    save(game_domain_name, seen);
+  return stats;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,315 @@
+#include "nexusmods/change_log.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nexusmods {
+
+namespace {
+
+constexpr size_t kFrameHeader = 8;        // length + crc
+constexpr size_t kBodyHeader = 1 + 4 * 8; // kind + 4 x int64
+constexpr uint32_t kMaxBody = 256u << 20; // sanity bound for readers
+constexpr const char *kSegmentSuffix = ".seg";
+
+constexpr std::array<uint32_t, 256> make_crc_table() {
+  std::array<uint32_t, 256> t{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+    t[i] = c;
+  }
+  return t;
+}
+constexpr auto kCrcTable = make_crc_table();
+
+// Fields are stored little-endian regardless of the host.
+void put_le(std::string &out, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; ++i)
+    out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+uint64_t get_le(const unsigned char *p, int bytes) {
+  uint64_t v = 0;
+  for (int i = 0; i < bytes; ++i)
+    v |= static_cast<uint64_t>(p[i]) << (8 * i);
+  return v;
+}
+
+std::string segment_path(const std::string &dir, uint64_t base) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%020llu",
+                static_cast<unsigned long long>(base));
+  return dir + "/" + name + kSegmentSuffix;
+}
+
+// Bases of all segments in `dir`, unsorted.
+std::vector<uint64_t> list_segments(const std::string &dir) {
+  std::vector<uint64_t> bases;
+  std::error_code ec;
+  for (const auto &e : std::filesystem::directory_iterator(dir, ec)) {
+    const auto name = e.path().filename().string();
+    if (name.size() != 20 + std::strlen(kSegmentSuffix) ||
+        name.compare(20, std::string::npos, kSegmentSuffix) != 0)
+      continue;
+    bases.push_back(std::stoull(name.substr(0, 20)));
+  }
+  return bases;
+}
+
+enum class Decode { Ok, Incomplete, Corrupt };
+
+// Decode the record framed at data[pos]; `size` is the readable length.
+Decode decode_at(const unsigned char *data, size_t size, size_t pos,
+                 ChangeRecord *out, size_t *frame_len) {
+  if (size - pos < kFrameHeader)
+    return Decode::Incomplete;
+  auto len = static_cast<uint32_t>(get_le(data + pos, 4));
+  auto crc = static_cast<uint32_t>(get_le(data + pos + 4, 4));
+  if (len < kBodyHeader || len > kMaxBody)
+    return Decode::Corrupt;
+  if (size - pos - kFrameHeader < len)
+    return Decode::Incomplete;
+  const unsigned char *body = data + pos + kFrameHeader;
+  if (crc32({reinterpret_cast<const char *>(body), len}) != crc)
+    return Decode::Corrupt;
+  *frame_len = kFrameHeader + len;
+  if (out) {
+    out->kind = static_cast<ChangeRecord::Kind>(body[0]);
+    out->game_id = static_cast<int64_t>(get_le(body + 1, 8));
+    out->mod_id = static_cast<int64_t>(get_le(body + 9, 8));
+    out->file_id = static_cast<int64_t>(get_le(body + 17, 8));
+    out->timestamp = static_cast<int64_t>(get_le(body + 25, 8));
+    out->payload.assign(reinterpret_cast<const char *>(body + kBodyHeader),
+                        len - kBodyHeader);
+  }
+  return Decode::Ok;
+}
+
+} // namespace
+
+uint32_t crc32(std::string_view data) {
+  uint32_t c = 0xffffffffu;
+  for (unsigned char b : data)
+    c = kCrcTable[(c ^ b) & 0xff] ^ (c >> 8);
+  return c ^ 0xffffffffu;
+}
+
+ChangeLog::~ChangeLog() {
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+bool ChangeLog::open(const std::string &directory, size_t segment_bytes) {
+  std::lock_guard<std::mutex> l(mutex_);
+  if (fd_ >= 0)
+    return false;
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+  if (ec)
+    return false;
+  directory_ = directory;
+  segment_bytes_ = segment_bytes;
+
+  uint64_t base = 0;
+  for (uint64_t b : list_segments(directory))
+    base = std::max(base, b);
+  if (!open_segment_locked(base))
+    return false;
+
+  // Find the end of the last complete record; anything after it is a write
+  // that never finished.
+  struct stat st {};
+  if (::fstat(fd_, &st) != 0)
+    return false;
+  size_t size = static_cast<size_t>(st.st_size), valid = 0;
+  if (size > 0) {
+    void *m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (m == MAP_FAILED)
+      return false;
+    auto *data = static_cast<const unsigned char *>(m);
+    size_t len = 0;
+    while (decode_at(data, size, valid, nullptr, &len) == Decode::Ok)
+      valid += len;
+    ::munmap(m, size);
+    if (valid != size && ::ftruncate(fd_, static_cast<off_t>(valid)) != 0)
+      return false;
+  }
+  end_ = base + valid;
+  return true;
+}
+
+bool ChangeLog::open_segment_locked(uint64_t base) {
+  int fd = ::open(segment_path(directory_, base).c_str(),
+                  O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return false;
+  if (fd_ >= 0)
+    ::close(fd_);
+  fd_ = fd;
+  segment_base_ = base;
+  return true;
+}
+
+std::optional<uint64_t> ChangeLog::append(const ChangeRecord &record) {
+  std::string frame;
+  frame.reserve(kFrameHeader + kBodyHeader + record.payload.size());
+  frame.resize(kFrameHeader);
+  frame.push_back(static_cast<char>(record.kind));
+  put_le(frame, static_cast<uint64_t>(record.game_id), 8);
+  put_le(frame, static_cast<uint64_t>(record.mod_id), 8);
+  put_le(frame, static_cast<uint64_t>(record.file_id), 8);
+  put_le(frame, static_cast<uint64_t>(record.timestamp), 8);
+  frame += record.payload;
+  std::string_view body(frame.data() + kFrameHeader,
+                        frame.size() - kFrameHeader);
+  if (body.size() > kMaxBody)
+    return std::nullopt;
+  std::string head;
+  put_le(head, body.size(), 4);
+  put_le(head, crc32(body), 4);
+  std::memcpy(frame.data(), head.data(), kFrameHeader);
+
+  std::lock_guard<std::mutex> l(mutex_);
+  if (fd_ < 0)
+    return std::nullopt;
+  if (end_ > segment_base_ && end_ - segment_base_ >= segment_bytes_) {
+    ::fdatasync(fd_);
+    if (!open_segment_locked(end_))
+      return std::nullopt;
+  }
+
+  size_t written = 0;
+  while (written < frame.size()) {
+    ssize_t n = ::write(fd_, frame.data() + written, frame.size() - written);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      // Drop the partial frame so the next append starts clean.
+      if (::ftruncate(fd_, static_cast<off_t>(end_ - segment_base_)) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+      }
+      return std::nullopt;
+    }
+    written += static_cast<size_t>(n);
+  }
+  uint64_t offset = end_;
+  end_ += frame.size();
+  return offset;
+}
+
+bool ChangeLog::flush() {
+  std::lock_guard<std::mutex> l(mutex_);
+  return fd_ >= 0 && ::fdatasync(fd_) == 0;
+}
+
+uint64_t ChangeLog::end_offset() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return end_;
+}
+
+std::string ChangeLog::directory() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return fd_ >= 0 ? directory_ : std::string();
+}
+
+ChangeLogReader::ChangeLogReader(std::string directory, uint64_t cursor)
+    : directory_(std::move(directory)), cursor_(cursor) {}
+
+ChangeLogReader::~ChangeLogReader() { unmap(); }
+
+void ChangeLogReader::unmap() {
+  if (data_)
+    ::munmap(const_cast<unsigned char *>(data_), mapped_);
+  if (fd_ >= 0)
+    ::close(fd_);
+  data_ = nullptr;
+  mapped_ = 0;
+  fd_ = -1;
+}
+
+// Makes sure the segment holding the cursor is mapped in full, moving on to
+// the next segment when the cursor sits at the end of the current one.
+bool ChangeLogReader::map_segment_for(uint64_t offset) {
+  auto open_base = [&](uint64_t base) {
+    unmap();
+    fd_ = ::open(segment_path(directory_, base).c_str(), O_RDONLY | O_CLOEXEC);
+    base_ = base;
+    return fd_ >= 0;
+  };
+
+  if (fd_ < 0 || offset < base_) {
+    std::optional<uint64_t> best;
+    for (uint64_t b : list_segments(directory_))
+      if (b <= offset && (!best || b > *best))
+        best = b;
+    if (!best || !open_base(*best))
+      return false;
+  }
+
+  for (int hop = 0; hop < 2; ++hop) {
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0)
+      return false;
+    auto size = static_cast<size_t>(st.st_size);
+    if (size != mapped_) {
+      if (data_)
+        ::munmap(const_cast<unsigned char *>(data_), mapped_);
+      data_ = nullptr;
+      mapped_ = 0;
+      if (size > 0) {
+        void *m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+        if (m == MAP_FAILED)
+          return false;
+        data_ = static_cast<const unsigned char *>(m);
+        mapped_ = size;
+      }
+    }
+    if (offset - base_ < mapped_ || offset == base_)
+      return true;
+    // At the end of this segment: the writer rolls to a segment based
+    // exactly here.
+    if (!std::filesystem::exists(segment_path(directory_, offset)))
+      return true;
+    if (!open_base(offset))
+      return false;
+  }
+  return true;
+}
+
+std::optional<ChangeRecord> ChangeLogReader::next() {
+  if (corrupt_ || !map_segment_for(cursor_) || !data_)
+    return std::nullopt;
+  size_t pos = static_cast<size_t>(cursor_ - base_);
+  if (pos >= mapped_)
+    return std::nullopt;
+
+  ChangeRecord r;
+  size_t len = 0;
+  switch (decode_at(data_, mapped_, pos, &r, &len)) {
+  case Decode::Incomplete:
+    return std::nullopt; // the writer is mid-append
+  case Decode::Corrupt:
+    corrupt_ = true;
+    return std::nullopt;
+  case Decode::Ok:
+    break;
+  }
+  r.offset = cursor_;
+  cursor_ += len;
+  return r;
+}
+
+} // namespace nexusmods
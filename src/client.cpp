@@ -6,48 +6,373 @@
 #include <thread>
 
 #include "rapidjson/error/en.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#include "trace.h"
 
 namespace nexusmods {
 
 using namespace std::chrono_literals;
 
+namespace {
+
+// Initial body capacity when the server doesn't send Content-Length, and the
+// most we trust a Content-Length header for pre-allocation.
+constexpr size_t kDefaultBodyHint = 64 * 1024;
+constexpr size_t kMaxBodyHint = 64 * 1024 * 1024;
+
+rapidjson::Document error_json(int code, const std::string &message,
+                               const std::string &path) {
+  rapidjson::Document err;
+  err.SetObject();
+  auto &alloc = err.GetAllocator();
+  err.AddMember("code", code, alloc);
+  err.AddMember("message", rapidjson::Value(message.c_str(), alloc), alloc);
+  err.AddMember("endpoint", rapidjson::Value(path.c_str(), alloc), alloc);
+  return err;
+}
+
+// Error document for a missing or non-2xx response, nullopt if the body is
+// worth parsing.
+std::optional<rapidjson::Document>
+response_error(const std::optional<NexusResponse> &r, const std::string &path) {
+  if (!r) {
+    // {"code":998,"message":"API error - get() failed"}
+    return error_json(998, "[ERROR] HTTP request failed (no response object).",
+                      path);
+  }
+  if (r->status < 200 || r->status >= 300) {
+    // failure
+    std::ostringstream oss;
+    oss << "[ERROR] HTTP request failed with status " << r->status;
+    if (!r->body.empty())
+      oss << " | Body: " << r->body.substr(0, 300);
+    return error_json(997, oss.str(), path);
+  }
+  return std::nullopt;
+}
+
+rapidjson::Document parse_error_json(rapidjson::ParseResult ok,
+                                     const std::string &path) {
+  std::ostringstream oss;
+  oss << "[ERROR] JSON parse failed: " << rapidjson::GetParseError_En(ok.Code())
+      << " (offset " << ok.Offset() << ")";
+  return error_json(996, oss.str(), path);
+}
+
+// Turn a raw response into the Document get_json hands out: either the parsed
+// body or an error document.
+rapidjson::Document decode_json(const std::optional<NexusResponse> &r,
+                                const std::string &path) {
+  if (auto err = response_error(r, path))
+    return std::move(*err);
+
+  NEXUSMODS_TRACE2(parse_start, path.c_str(), r->body.size());
+  rapidjson::Document d;
+  rapidjson::ParseResult ok = d.Parse(r->body.c_str(), r->body.size());
+  NEXUSMODS_TRACE2(parse_done, path.c_str(), ok ? 1 : 0);
+  if (!ok)
+    return parse_error_json(ok, path);
+  return d;
+}
+
+LazyDocument to_lazy(const rapidjson::Document &d) {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  d.Accept(writer);
+  return LazyDocument(std::string(sb.GetString(), sb.GetSize()));
+}
+
+std::atomic<uint64_t> next_client_instance{1};
+
+// Per-thread reference to the last config or component snapshot a thread
+// read, as in GameDirectory: while it is current, a read costs one atomic
+// load of the client's version counter plus a reference count increment.
+// Weak, so a thread doesn't keep a destroyed client's transport alive.
+template <typename T> struct SnapshotCache {
+  uint64_t instance = 0;
+  uint64_t version = 0;
+  std::weak_ptr<const T> value;
+
+  std::shared_ptr<const T>
+  get(uint64_t client, uint64_t current,
+      const std::atomic<std::shared_ptr<const T>> &src) {
+    std::shared_ptr<const T> v;
+    if (instance == client && version == current)
+      v = value.lock();
+    if (!v) {
+      v = src.load(std::memory_order_acquire);
+      value = v;
+      instance = client;
+      version = current;
+    }
+    return v;
+  }
+};
+thread_local SnapshotCache<ClientConfig> config_cache;
+
+} // namespace
+
 Client::Client(const std::string &api_key, const std::string &host, int port,
                const std::string &user_agent)
-    : api_key_(api_key), api_header_name_("apikey"), user_agent_(user_agent),
-      timeout_seconds_(30), backoff_cb_(nullptr) {
-  // Create SSL client; httplib's SSLClient needs host and port
-  client_ = new httplib::SSLClient(host.c_str(), port);
+    : instance_(next_client_instance.fetch_add(1)) {
+  ClientConfig config;
+  config.api_key = api_key;
+  config.user_agent = user_agent;
+  config_.store(std::make_shared<const ClientConfig>(std::move(config)));
+  Components components;
+  components.transport = std::make_shared<HttplibTransport>(host, port);
+  components_.store(std::make_shared<const Components>(std::move(components)));
 }
 
 Client::~Client() {
-  delete client_;
-  client_ = nullptr;
+  shutdown(std::chrono::seconds(5));
+  // Nothing may still be using the client once it is freed. A call that
+  // reached the transport after the cancel is cancelled on the next pass.
+  while (!wait_drained(std::chrono::steady_clock::now() +
+                       std::chrono::seconds(1)))
+    if (auto transport = components()->transport)
+      transport->cancel_all();
 }
 
-void Client::set_api_header_name(const std::string &header_name) {
+bool Client::shutdown(std::chrono::milliseconds deadline) {
+  const auto until = std::chrono::steady_clock::now() + deadline;
+  {
+    std::lock_guard<std::mutex> l(shutdown_mutex_);
+    if (!shutting_down_)
+      hooks_due_ = true;
+    shutting_down_ = true;
+  }
+  shutdown_cv_.notify_all(); // cuts backoff sleeps short
+
+  bool drained = wait_drained(until);
+  auto transport = components()->transport;
+  if (!drained && transport) {
+    transport->cancel_all();
+    // Cancelled calls return within moments; a transport that ignores
+    // cancel_all() is left to the destructor.
+    wait_drained(std::chrono::steady_clock::now() + std::chrono::seconds(1));
+  }
+
+  bool run_hooks;
+  {
+    std::lock_guard<std::mutex> l(shutdown_mutex_);
+    run_hooks = take_hooks_locked();
+  }
+  if (run_hooks)
+    finish_shutdown();
+  return drained;
+}
+
+bool Client::take_hooks_locked() {
+  if (!hooks_due_ || in_flight_ != 0)
+    return false;
+  hooks_due_ = false;
+  ++in_flight_;
+  return true;
+}
+
+void Client::finish_shutdown() {
+  std::vector<std::function<void()>> hooks;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    hooks = shutdown_hooks_;
+  }
+  for (auto &hook : hooks)
+    hook();
+  if (auto logger = components()->logger)
+    logger->flush();
+  // Notified under the lock: the destructor may free the client as soon as
+  // it sees the count reach zero.
+  std::lock_guard<std::mutex> l(shutdown_mutex_);
+  --in_flight_;
+  shutdown_cv_.notify_all();
+}
+
+void Client::add_shutdown_hook(std::function<void()> hook) {
   std::lock_guard<std::mutex> l(mutex_);
-  api_header_name_ = header_name;
+  shutdown_hooks_.push_back(std::move(hook));
 }
 
-void Client::set_timeout_seconds(int seconds) {
+bool Client::enter_request() {
+  std::lock_guard<std::mutex> l(shutdown_mutex_);
+  if (shutting_down_)
+    return false;
+  ++in_flight_;
+  return true;
+}
+
+void Client::leave_request() {
+  {
+    std::lock_guard<std::mutex> l(shutdown_mutex_);
+    if (--in_flight_ != 0)
+      return;
+    // The last call out after a shutdown that timed out runs the hooks.
+    if (!take_hooks_locked()) {
+      shutdown_cv_.notify_all(); // under the lock, as in finish_shutdown()
+      return;
+    }
+  }
+  finish_shutdown();
+}
+
+bool Client::backoff_sleep(std::chrono::milliseconds duration) {
+  std::unique_lock<std::mutex> l(shutdown_mutex_);
+  return !shutdown_cv_.wait_for(l, duration, [&] { return shutting_down_; });
+}
+
+bool Client::wait_drained(std::chrono::steady_clock::time_point until) {
+  std::unique_lock<std::mutex> l(shutdown_mutex_);
+  return shutdown_cv_.wait_until(l, until, [&] { return in_flight_ == 0; });
+}
+
+std::shared_ptr<const ClientConfig> Client::config() const {
+  return config_cache.get(
+      instance_, config_version_.load(std::memory_order_acquire), config_);
+}
+
+std::shared_ptr<const Client::Components> Client::components() const {
+  thread_local SnapshotCache<Components> cache;
+  return cache.get(instance_,
+                   components_version_.load(std::memory_order_acquire),
+                   components_);
+}
+
+void Client::update_components(
+    const std::function<void(Components &)> &edit) {
   std::lock_guard<std::mutex> l(mutex_);
-  timeout_seconds_ = seconds;
-  if (client_) {
-    client_->set_connection_timeout(std::chrono::seconds(timeout_seconds_));
-    client_->set_read_timeout(std::chrono::seconds(timeout_seconds_));
-    client_->set_write_timeout(std::chrono::seconds(timeout_seconds_));
+  Components next = *components_.load(std::memory_order_acquire);
+  edit(next);
+  components_.store(std::make_shared<const Components>(std::move(next)),
+                    std::memory_order_release);
+  components_version_.fetch_add(1, std::memory_order_release);
+}
+
+void Client::set_config(ClientConfig config) {
+  update_config([&](ClientConfig &c) { c = std::move(config); });
+}
+
+void Client::update_config(const std::function<void(ClientConfig &)> &edit) {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    ClientConfig next = *config_.load(std::memory_order_acquire);
+    edit(next);
+    config_.store(std::make_shared<const ClientConfig>(std::move(next)),
+                  std::memory_order_release);
+    config_version_.fetch_add(1, std::memory_order_release);
   }
+  // Not under mutex_: a transport may take its own lock here, which it also
+  // holds across requests. Applies the latest timeout, so racing updates
+  // settle on it.
+  if (auto transport = components()->transport)
+    transport->set_timeout(config_.load(std::memory_order_acquire)->timeout);
+}
+
+void Client::set_api_header_name(const std::string &header_name) {
+  update_config([&](ClientConfig &c) { c.api_header_name = header_name; });
+}
+
+void Client::set_timeout_seconds(int seconds) {
+  update_config(
+      [&](ClientConfig &c) { c.timeout = std::chrono::seconds(seconds); });
+}
+
+void Client::set_transport(std::shared_ptr<Transport> transport) {
+  if (transport)
+    transport->set_timeout(config()->timeout);
+  update_components([&](Components &c) { c.transport = std::move(transport); });
+}
+
+void Client::set_logger(std::shared_ptr<Logger> logger) {
+  update_components([&](Components &c) { c.logger = std::move(logger); });
+}
+
+void Client::set_request_registry(std::shared_ptr<RequestRegistry> registry) {
+  update_components([&](Components &c) { c.registry = std::move(registry); });
+}
+
+void Client::set_call_metrics(std::shared_ptr<CallMetrics> metrics) {
+  update_components(
+      [&](Components &c) { c.call_metrics = std::move(metrics); });
+}
+
+ClientMetrics Client::metrics_snapshot() {
+  auto parts = components();
+  ClientMetrics out;
+  if (parts->call_metrics)
+    out.endpoints = parts->call_metrics->snapshot();
+  if (parts->memory)
+    out.memory = parts->memory->snapshot();
+  if (parts->buffer_pool)
+    out.buffers = parts->buffer_pool->stats();
+  return out;
+}
+
+void Client::set_rate_limit_budget(std::shared_ptr<RateLimitBudget> budget) {
+  update_components([&](Components &c) { c.rate_budget = std::move(budget); });
 }
 
 void Client::set_backoff_callback(std::function<void(int)> cb) {
-  backoff_cb_ = cb;
+  update_config([&](ClientConfig &c) { c.on_backoff = std::move(cb); });
+}
+
+void Client::set_memory_accountant(
+    std::shared_ptr<MemoryAccountant> accountant) {
+  MemoryAccountant::SubsystemId id = 0;
+  if (accountant)
+    id = accountant->subsystem("response_bodies");
+  update_components([&](Components &c) {
+    c.memory = std::move(accountant);
+    c.body_subsystem = id;
+  });
 }
 
-httplib::Headers
-Client::build_auth_headers(const httplib::Headers &extra) const {
+void Client::set_buffer_pool(std::shared_ptr<BufferPool> pool) {
+  update_components([&](Components &c) { c.buffer_pool = std::move(pool); });
+}
+
+void Client::recycle(NexusResponse &&response) {
+  if (auto pool = components()->buffer_pool)
+    pool->release(std::move(response.body));
+}
+
+void Client::add_mod_listener(std::function<void(const Mod &)> listener) {
+  update_components(
+      [&](Components &c) { c.mod_listeners.push_back(std::move(listener)); });
+}
+
+void Client::notify_mods(const std::optional<rapidjson::Document> &doc) {
+  auto parts = components();
+  const auto &listeners = parts->mod_listeners;
+  if (listeners.empty() || !doc)
+    return;
+  auto emit = [&](const rapidjson::Value &v) {
+    if (auto mod = Mod::from_json(v))
+      for (auto &cb : listeners)
+        cb(*mod);
+  };
+  if (doc->IsArray()) {
+    for (const auto &v : doc->GetArray())
+      emit(v);
+  } else {
+    emit(*doc);
+  }
+}
+
+MemoryReservation Client::hold_body(const std::optional<NexusResponse> &r) {
+  auto parts = components();
+  if (!parts->memory || !r)
+    return MemoryReservation();
+  return parts->memory->charge(parts->body_subsystem, r->body.capacity());
+}
+
+httplib::Headers Client::build_auth_headers(const ClientConfig &config,
+                                            const httplib::Headers &extra) {
   httplib::Headers headers = extra;
-  headers.emplace(api_header_name_, api_key_);
-  headers.emplace("User-Agent", user_agent_);
+  headers.insert(config.default_headers.begin(), config.default_headers.end());
+  headers.emplace(config.api_header_name, config.api_key);
+  headers.emplace("User-Agent", config.user_agent);
   headers.emplace("Accept", "application/json");
   return headers;
 }
@@ -56,27 +381,129 @@ std::optional<NexusResponse>
 Client::perform_get_with_rate_limit(const std::string &path,
                                     const httplib::Params &params,
                                     const httplib::Headers &extra_headers) {
+  const std::shared_ptr<const ClientConfig> cfg = config();
   int attempt = 0;
-  int max_attempts = 6;
-  int base_backoff_seconds = 1;
+  int max_attempts = cfg->retry.max_attempts;
+  int base_backoff_seconds = cfg->retry.base_backoff_seconds;
+
+  NEXUSMODS_TRACE1(request_start, path.c_str());
+
+  // One snapshot for the whole call, retries included.
+  const std::shared_ptr<const Components> parts = components();
+  const auto &memory = parts->memory;
+  const auto &pool = parts->buffer_pool;
+  const auto &transport = parts->transport;
+  const auto &logger = parts->logger;
+  const auto &registry = parts->registry;
+  const auto &metrics = parts->call_metrics;
+  const auto &budget = parts->rate_budget;
+  if (metrics)
+    metrics->count_call(path);
+  RequestTracker tracker = registry ? registry->track(path) : RequestTracker();
+  const auto started = std::chrono::steady_clock::now();
+  auto elapsed_us = [&] {
+    return static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started)
+            .count());
+  };
+  // Retry reasons as in trace.h: 0 transport error, 1 429, 2 daily, 3 hourly.
+  auto log_retry = [&](int status, int reason, int seconds) {
+    if (!logger)
+      return;
+    logger->log(LogEvent::Retry, path, status, attempt, reason);
+    logger->log(LogEvent::Backoff, path, status, attempt, seconds);
+  };
+  auto log_done = [&](int status) {
+    if (logger)
+      logger->log(LogEvent::RequestDone, path, status, attempt, elapsed_us());
+  };
+  if (logger)
+    logger->log(LogEvent::RequestStart, path);
+
+  if (memory)
+    tracker.set_state(RequestState::WaitingForMemory);
+  if (!transport ||
+      (memory &&
+       !memory->wait_for_headroom(cfg->timeout))) {
+    NEXUSMODS_TRACE3(request_done, path.c_str(), -1, elapsed_us());
+    log_done(-1);
+    return std::nullopt;
+  }
 
+  std::string body;
   while (attempt < max_attempts) {
     attempt++;
 
-    auto headers = build_auth_headers(extra_headers);
+    CallMetrics::Scope header_phase(metrics.get(), path,
+                                    CallMetrics::Phase::Headers);
+    auto headers = build_auth_headers(*cfg, extra_headers);
+    header_phase.finish();
+    tracker.set_attempt(attempt);
+    tracker.set_state(RequestState::InTransport);
+
+    // Stream the body into a buffer sized from Content-Length up front, so it
+    // doesn't grow by reallocation while httplib appends to it.
+    auto on_response = [&](const httplib::Response &r) {
+      tracker.set_state(RequestState::ReadingBody);
+      size_t hint = kDefaultBodyHint;
+      if (r.has_header("Content-Length")) {
+        try {
+          hint = std::min<size_t>(
+              std::stoull(r.get_header_value("Content-Length")), kMaxBodyHint);
+        } catch (...) {
+        }
+      }
+      body.clear();
+      if (body.capacity() < hint) {
+        if (pool) {
+          pool->release(std::move(body));
+          body = pool->acquire(hint);
+        } else {
+          body.reserve(hint);
+        }
+      }
+      return true;
+    };
+    auto on_data = [&](const char *data, size_t len) {
+      body.append(data, len);
+      return true;
+    };
+
+    if (budget) {
+      auto wait = budget->delay(cfg->priority);
+      if (wait.count() > 0) {
+        tracker.backing_off(wait);
+        if (!backoff_sleep(wait))
+          break;
+        tracker.set_state(RequestState::InTransport);
+      }
+      budget->on_sent(cfg->priority);
+    }
 
+    CallMetrics::Scope transport_phase(metrics.get(), path,
+                                       CallMetrics::Phase::Transport);
+    tracker.set_state(RequestState::WaitingForConnection);
     httplib::Result res;
-    if (params.empty()) {
-      res = client_->Get(path.c_str(), headers);
-    } else {
-      res = client_->Get(path.c_str(), params, headers);
+    {
+      Transport::ConnectionHook connected(
+          [&] { tracker.set_state(RequestState::InTransport); });
+      res = transport->get(path, params, headers, on_response, on_data);
     }
+    transport_phase.finish();
+    if (res && budget)
+      budget->observe(res->headers);
 
     if (!res) {
       int sleep_seconds = base_backoff_seconds * (1 << std::min(attempt, 6));
-      if (backoff_cb_)
-        backoff_cb_(sleep_seconds);
-      std::this_thread::sleep_for(std::chrono::seconds(sleep_seconds));
+      NEXUSMODS_TRACE3(retry, path.c_str(), attempt, 0);
+      NEXUSMODS_TRACE2(backoff, path.c_str(), sleep_seconds);
+      log_retry(-1, 0, sleep_seconds);
+      tracker.backing_off(std::chrono::seconds(sleep_seconds));
+      if (cfg->on_backoff)
+        cfg->on_backoff(sleep_seconds);
+      if (!backoff_sleep(std::chrono::seconds(sleep_seconds)))
+        break;
       continue;
     }
 
@@ -88,27 +515,6 @@ Client::perform_get_with_rate_limit(const std::string &path,
       return it != response.headers.end() ? it->second : "";
     };
 
-    auto parse_date = [](const std::string& date_str) -> std::optional<std::chrono::system_clock::time_point> {
-      std::tm tm = {};
-      std::istringstream ss(date_str);
-
-      // Try RFC 1123: "Wed, 21 Oct 2015 07:28:00 GMT"
-      ss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
-      if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm(&tm));
-
-      // Try ISO: "2019-02-02 00:00:00 +0000"
-      ss.clear(); ss.str(date_str);
-      ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-      if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm(&tm));
-
-      // Try ISO with T: "2019-02-02T00:00:00"
-      ss.clear(); ss.str(date_str);
-      ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-      if (!ss.fail()) return std::chrono::system_clock::from_time_t(timegm(&tm));
-
-      return std::nullopt;
-    };
-
     // Rate-Limit Check (429 Too Many Requests)
     //   https://developer.mozilla.org/en-US/docs/Web/HTTP/Reference/Headers/Retry-After
     if (response.status == 429) {
@@ -120,17 +526,22 @@ Client::perform_get_with_rate_limit(const std::string &path,
         retry_seconds = std::stoi(retry_header);
       } catch (...) {
         // Now check for "Retry-After: Wed, 21 Oct 2015 07:28:00 GMT"
-        auto parsed = parse_date(retry_header);
+        auto parsed = parse_rate_limit_date(retry_header);
         if (parsed) {
           auto now = std::chrono::system_clock::now();
           retry_seconds = std::chrono::duration_cast<std::chrono::seconds>(*parsed - now).count() + 1;
         }
       }
 
-      if (backoff_cb_)
-        backoff_cb_(retry_seconds);
+      NEXUSMODS_TRACE3(retry, path.c_str(), attempt, 1);
+      NEXUSMODS_TRACE2(backoff, path.c_str(), std::max(retry_seconds, 1));
+      log_retry(response.status, 1, std::max(retry_seconds, 1));
+      tracker.backing_off(std::chrono::seconds(std::max(retry_seconds, 1)));
+      if (cfg->on_backoff)
+        cfg->on_backoff(retry_seconds);
       // sleep at least 1 second
-      std::this_thread::sleep_for(std::chrono::seconds(std::max(retry_seconds, 1)));
+      if (!backoff_sleep(std::chrono::seconds(std::max(retry_seconds, 1))))
+        break;
       continue;
     }
 
@@ -145,15 +556,20 @@ Client::perform_get_with_rate_limit(const std::string &path,
     // If remaining == 0, sleep until reset if available
     if (hdr("X-RL-Daily-Remaining") == "0") {
       int retry_seconds = base_backoff_seconds * (1 << attempt);
-      auto parsed = parse_date(hdr("X-RL-Daily-Reset"));
+      auto parsed = parse_rate_limit_date(hdr("X-RL-Daily-Reset"));
       if (parsed) {
         auto now = std::chrono::system_clock::now();
         retry_seconds = std::chrono::duration_cast<std::chrono::seconds>(*parsed - now).count() + 1;
       }
 
-      if (backoff_cb_)
-        backoff_cb_(retry_seconds);
-      std::this_thread::sleep_for(std::chrono::seconds(std::max(retry_seconds, 1)));
+      NEXUSMODS_TRACE3(retry, path.c_str(), attempt, 2);
+      NEXUSMODS_TRACE2(backoff, path.c_str(), std::max(retry_seconds, 1));
+      log_retry(response.status, 2, std::max(retry_seconds, 1));
+      tracker.backing_off(std::chrono::seconds(std::max(retry_seconds, 1)));
+      if (cfg->on_backoff)
+        cfg->on_backoff(retry_seconds);
+      if (!backoff_sleep(std::chrono::seconds(std::max(retry_seconds, 1))))
+        break;
       continue;
     }
 
@@ -162,77 +578,147 @@ Client::perform_get_with_rate_limit(const std::string &path,
     //
     if (hdr("X-RL-Hourly-Remaining") == "0") {
       int retry_seconds = base_backoff_seconds * (1 << attempt);
-      auto parsed = parse_date(hdr("X-RL-Hourly-Reset"));
+      auto parsed = parse_rate_limit_date(hdr("X-RL-Hourly-Reset"));
 
       if (parsed) {
         auto now = std::chrono::system_clock::now();
         retry_seconds = std::chrono::duration_cast<std::chrono::seconds>(*parsed - now).count() + 1;
       }
 
-      if (backoff_cb_)
-        backoff_cb_(retry_seconds);
-      std::this_thread::sleep_for(std::chrono::seconds(std::max(retry_seconds, 1)));
+      NEXUSMODS_TRACE3(retry, path.c_str(), attempt, 3);
+      NEXUSMODS_TRACE2(backoff, path.c_str(), std::max(retry_seconds, 1));
+      log_retry(response.status, 3, std::max(retry_seconds, 1));
+      tracker.backing_off(std::chrono::seconds(std::max(retry_seconds, 1)));
+      if (cfg->on_backoff)
+        cfg->on_backoff(retry_seconds);
+      if (!backoff_sleep(std::chrono::seconds(std::max(retry_seconds, 1))))
+        break;
       continue;
     }
 
     NexusResponse out;
     out.status = response.status;
-    out.body = response.body;
+    out.body = std::move(body);
     out.headers = response.headers;
+    NEXUSMODS_TRACE3(request_done, path.c_str(), out.status, elapsed_us());
+    log_done(out.status);
     return out;
   }
 
+  if (pool)
+    pool->release(std::move(body));
+  NEXUSMODS_TRACE3(request_done, path.c_str(), -1, elapsed_us());
+  log_done(-1);
   return std::nullopt;
 }
 
 std::optional<NexusResponse>
 Client::get(const std::string &path, const httplib::Params &params,
             const httplib::Headers &extra_headers) {
+  InFlight in_flight(*this);
+  if (!in_flight)
+    return std::nullopt;
   return perform_get_with_rate_limit(path, params, extra_headers);
 }
 
 std::optional<rapidjson::Document>
 Client::get_json(const std::string &path, const httplib::Params &params,
                  const httplib::Headers &extra_headers) {
+  InFlight in_flight(*this);
+  auto r = get(path, params, extra_headers);
+  auto hold = hold_body(r);
+  auto metrics = components()->call_metrics;
+  CallMetrics::Scope parse_phase(metrics.get(), path, CallMetrics::Phase::Parse);
+  auto d = decode_json(r, path);
+  parse_phase.finish();
+  if (r)
+    recycle(std::move(*r));
+  return d;
+}
 
-  auto error_json = [](int code, const std::string &message,
-                       const std::string &path) {
-    rapidjson::Document err;
-    err.SetObject();
-    auto &alloc = err.GetAllocator();
-    err.AddMember("code", code, alloc);
-    err.AddMember("message", rapidjson::Value(message.c_str(), alloc), alloc);
-    err.AddMember("endpoint", rapidjson::Value(path.c_str(), alloc), alloc);
-    return err;
+std::future<std::optional<rapidjson::Document>>
+Client::get_json_async(const std::string &path, const httplib::Params &params,
+                       const httplib::Headers &extra_headers) {
+  InFlight in_flight(*this);
+  auto r = get(path, params, extra_headers);
+  auto hold = std::make_shared<MemoryReservation>(hold_body(r));
+
+  using Promise = std::promise<std::optional<rapidjson::Document>>;
+  auto promise = std::make_shared<Promise>();
+  auto result = promise->get_future();
+  auto response =
+      std::make_shared<std::optional<NexusResponse>>(std::move(r));
+  auto parts = components();
+  const auto &pool = parts->parse_pool;
+  auto buffers = parts->buffer_pool;
+  auto metrics = parts->call_metrics;
+  auto job = [promise, response, hold, buffers, metrics, path] {
+    CallMetrics::Scope parse_phase(metrics.get(), path,
+                                   CallMetrics::Phase::Parse);
+    auto d = decode_json(*response, path);
+    parse_phase.finish();
+    promise->set_value(std::move(d));
+    if (buffers && *response)
+      buffers->release(std::move((*response)->body));
+    hold->reset();
   };
 
+  if (!pool || !pool->try_submit(job))
+    job();
+  return result;
+}
+
+void Client::set_parse_pool(std::shared_ptr<ParsePool> pool) {
+  update_components([&](Components &c) { c.parse_pool = std::move(pool); });
+}
+
+std::optional<rapidjson::Document>
+Client::get_json_projected(const std::string &path,
+                           const FieldProjection &projection,
+                           const httplib::Params &params,
+                           const httplib::Headers &extra_headers) {
+  InFlight in_flight(*this);
   auto r = get(path, params, extra_headers);
-  if (!r) {
-    // {"code":998,"message":"API error - get() failed"}
-    return error_json(998, "[ERROR] HTTP request failed (no response object).",
-                      path);
-  }
-  if (r->status < 200 || r->status >= 300) {
-    // failure
-    std::ostringstream oss;
-    oss << "[ERROR] HTTP request failed with status " << r->status;
-    if (!r->body.empty())
-      oss << " | Body: " << r->body.substr(0, 300);
-    return error_json(997, oss.str(), path);
-  }
+  if (auto err = response_error(r, path))
+    return err;
 
+  auto hold = hold_body(r);
   rapidjson::Document d;
-  rapidjson::ParseResult ok = d.Parse(r->body.c_str(), r->body.size());
+  auto metrics = components()->call_metrics;
+  CallMetrics::Scope parse_phase(metrics.get(), path, CallMetrics::Phase::Parse);
+  NEXUSMODS_TRACE2(parse_start, path.c_str(), r->body.size());
+  rapidjson::ParseResult ok = parse_projected(r->body, projection, d);
+  NEXUSMODS_TRACE2(parse_done, path.c_str(), ok ? 1 : 0);
+  parse_phase.finish();
+  recycle(std::move(*r));
+  if (!ok)
+    return parse_error_json(ok, path);
+
+  return d;
+}
 
-  if (!ok) {
+std::optional<LazyDocument>
+Client::get_json_lazy(const std::string &path, const httplib::Params &params,
+                      const httplib::Headers &extra_headers) {
+  InFlight in_flight(*this);
+  auto r = get(path, params, extra_headers);
+  if (auto err = response_error(r, path))
+    return to_lazy(*err);
+
+  auto hold = hold_body(r);
+  auto metrics = components()->call_metrics;
+  CallMetrics::Scope parse_phase(metrics.get(), path, CallMetrics::Phase::Parse);
+  NEXUSMODS_TRACE2(parse_start, path.c_str(), r->body.size());
+  LazyDocument doc(std::move(r->body));
+  NEXUSMODS_TRACE2(parse_done, path.c_str(), doc.has_error() ? 0 : 1);
+  parse_phase.finish();
+  if (doc.has_error()) {
     std::ostringstream oss;
-    oss << "[ERROR] JSON parse failed: "
-        << rapidjson::GetParseError_En(ok.Code()) << " (offset " << ok.Offset()
-        << ")";
-    return error_json(996, oss.str(), path);
+    oss << "[ERROR] JSON parse failed: malformed structure (offset "
+        << *doc.error_offset() << ")";
+    return to_lazy(error_json(996, oss.str(), path));
   }
-
-  return d;
+  return doc;
 }
 
 std::optional<rapidjson::Document>
@@ -256,21 +742,27 @@ std::optional<rapidjson::Document>
 Client::get_latest_added(const std::string &game_domain_name) {
   std::ostringstream path;
   path << "/v1/games/" << game_domain_name << "/mods/latest_added.json";
-  return get_json(path.str());
+  auto d = get_json(path.str());
+  notify_mods(d);
+  return d;
 }
 
 std::optional<rapidjson::Document>
 Client::get_latest_updated(const std::string &game_domain_name) {
   std::ostringstream path;
   path << "/v1/games/" << game_domain_name << "/mods/latest_updated.json";
-  return get_json(path.str());
+  auto d = get_json(path.str());
+  notify_mods(d);
+  return d;
 }
 
 std::optional<rapidjson::Document>
 Client::get_trending(const std::string &game_domain_name) {
   std::ostringstream path;
   path << "/v1/games/" << game_domain_name << "/mods/trending.json";
-  return get_json(path.str());
+  auto d = get_json(path.str());
+  notify_mods(d);
+  return d;
 }
 
 std::optional<rapidjson::Document>
@@ -278,7 +770,17 @@ Client::get_mod(const std::string &game_domain_name,
                 const std::string &mod_id) {
   std::ostringstream path;
   path << "/v1/games/" << game_domain_name << "/mods/" << mod_id << ".json";
-  return get_json(path.str());
+  auto d = get_json(path.str());
+  notify_mods(d);
+  return d;
+}
+
+std::optional<rapidjson::Document>
+Client::get_mod(const std::string &game_domain_name, const std::string &mod_id,
+                const FieldProjection &projection) {
+  std::ostringstream path;
+  path << "/v1/games/" << game_domain_name << "/mods/" << mod_id << ".json";
+  return get_json_projected(path.str(), projection);
 }
 
 std::optional<rapidjson::Document>
@@ -300,6 +802,17 @@ Client::list_mod_files(const std::string &game_domain_name,
   return get_json(path.str(), params);
 }
 
+std::optional<rapidjson::Document>
+Client::list_mod_files(const std::string &game_domain_name,
+                       const std::string &mod_id,
+                       const FieldProjection &projection,
+                       const httplib::Params &params) {
+  std::ostringstream path;
+  path << "/v1/games/" << game_domain_name << "/mods/" << mod_id
+       << "/files.json";
+  return get_json_projected(path.str(), projection, params);
+}
+
 std::optional<rapidjson::Document>
 Client::get_mod_file(const std::string &game_domain_name,
                      const std::string &mod_id, const std::string &file_id) {
@@ -0,0 +1,251 @@
+#include "nexusmods/game_directory.h"
+
+#include <algorithm>
+
+#include "nexusmods/client.h"
+
+namespace nexusmods {
+
+namespace {
+
+constexpr int64_t kMaxDenseId = 1 << 20;
+
+uint64_t mix(uint64_t x) {
+  // splitmix64 finalizer
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+uint64_t hash_name(std::string_view s) {
+  uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+uint64_t seeded(uint64_t h, uint32_t seed) {
+  return mix(h ^ (static_cast<uint64_t>(seed) * 0x9e3779b97f4a7c15ULL));
+}
+
+} // namespace
+
+// Hash-and-displace construction: keys are grouped into buckets by their
+// plain hash, and each bucket (largest first) searches for a seed that sends
+// all of its keys to free slots. Lookups are two hashes and one comparison.
+GameTable::GameTable(std::vector<Game> games) : games_(std::move(games)) {
+  for (auto &g : games_)
+    std::sort(g.categories.begin(), g.categories.end(),
+              [](const GameCategory &a, const GameCategory &b) {
+                return a.category_id < b.category_id;
+              });
+
+  const size_t n = games_.size();
+  if (n == 0)
+    return;
+
+  std::vector<uint64_t> hashes(n);
+  for (size_t i = 0; i < n; ++i)
+    hashes[i] = hash_name(games_[i].domain_name);
+
+  const size_t bucket_count = n / 4 + 1;
+  std::vector<std::vector<uint32_t>> buckets(bucket_count);
+  for (size_t i = 0; i < n; ++i)
+    buckets[mix(hashes[i]) % bucket_count].push_back(static_cast<uint32_t>(i));
+
+  std::vector<uint32_t> order(bucket_count);
+  for (size_t b = 0; b < bucket_count; ++b)
+    order[b] = static_cast<uint32_t>(b);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  // ~80% load keeps the seed search short.
+  const size_t slot_count = n + n / 4 + 1;
+  seeds_.assign(bucket_count, 0);
+  slots_.assign(slot_count, -1);
+  std::vector<size_t> taken;
+  for (uint32_t b : order) {
+    const auto &keys = buckets[b];
+    if (keys.empty())
+      break;
+    for (uint32_t seed = 1;; ++seed) {
+      taken.clear();
+      bool ok = true;
+      for (uint32_t k : keys) {
+        size_t slot = seeded(hashes[k], seed) % slot_count;
+        if (slots_[slot] != -1 ||
+            std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+          ok = false;
+          break;
+        }
+        taken.push_back(slot);
+      }
+      // Identical domain names can never separate; keep the first.
+      if (!ok && seed > 1u << 16) {
+        taken.clear();
+        for (uint32_t k : keys) {
+          size_t slot = seeded(hashes[k], 1) % slot_count;
+          if (slots_[slot] == -1)
+            slots_[slot] = static_cast<int32_t>(k);
+        }
+        seeds_[b] = 1;
+        break;
+      }
+      if (ok) {
+        for (size_t i = 0; i < keys.size(); ++i)
+          slots_[taken[i]] = static_cast<int32_t>(keys[i]);
+        seeds_[b] = seed;
+        break;
+      }
+    }
+  }
+
+  int64_t max_id = 0;
+  for (const auto &g : games_)
+    if (g.id <= kMaxDenseId)
+      max_id = std::max(max_id, g.id);
+  by_id_.assign(static_cast<size_t>(max_id) + 1, -1);
+  for (size_t i = 0; i < n; ++i) {
+    int64_t id = games_[i].id;
+    if (id >= 0 && id <= kMaxDenseId)
+      by_id_[static_cast<size_t>(id)] = static_cast<int32_t>(i);
+    else
+      sparse_ids_.emplace_back(id, static_cast<int32_t>(i));
+  }
+  std::sort(sparse_ids_.begin(), sparse_ids_.end());
+}
+
+const Game *GameTable::by_domain(std::string_view domain_name) const {
+  if (games_.empty())
+    return nullptr;
+  uint64_t h = hash_name(domain_name);
+  uint32_t seed = seeds_[mix(h) % seeds_.size()];
+  int32_t idx = slots_[seeded(h, seed) % slots_.size()];
+  if (idx < 0 || games_[idx].domain_name != domain_name)
+    return nullptr;
+  return &games_[idx];
+}
+
+const Game *GameTable::by_id(int64_t id) const {
+  if (id >= 0 && static_cast<uint64_t>(id) < by_id_.size()) {
+    int32_t idx = by_id_[static_cast<size_t>(id)];
+    return idx < 0 ? nullptr : &games_[idx];
+  }
+  auto it = std::lower_bound(sparse_ids_.begin(), sparse_ids_.end(),
+                             std::make_pair(id, INT32_MIN));
+  if (it == sparse_ids_.end() || it->first != id)
+    return nullptr;
+  return &games_[it->second];
+}
+
+const GameCategory *GameTable::category(const Game &game,
+                                        int64_t category_id) const {
+  auto it = std::lower_bound(game.categories.begin(), game.categories.end(),
+                             category_id,
+                             [](const GameCategory &c, int64_t id) {
+                               return c.category_id < id;
+                             });
+  if (it == game.categories.end() || it->category_id != category_id)
+    return nullptr;
+  return &*it;
+}
+
+namespace {
+
+std::atomic<uint64_t> next_instance{1};
+
+// Per-thread copy of the last table a thread read from each directory. While
+// it is current, a read costs one atomic load of the directory's version
+// counter and a scan of a few slots.
+struct CacheSlot {
+  uint64_t instance = 0;
+  uint64_t version = 0;
+  std::weak_ptr<const char> alive;
+  std::shared_ptr<const GameTable> table;
+};
+thread_local std::vector<CacheSlot> cache;
+
+} // namespace
+
+GameDirectory::GameDirectory(Client &client, std::chrono::seconds interval)
+    : client_(client), instance_(next_instance.fetch_add(1)),
+      alive_(std::make_shared<const char>()),
+      table_(std::make_shared<const GameTable>()) {
+  refresher_ = std::thread([this, interval] { run(interval); });
+}
+
+GameDirectory::~GameDirectory() {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  refresher_.join();
+}
+
+const GameTable &GameDirectory::current() const {
+  uint64_t v = version_.load(std::memory_order_acquire);
+  for (auto &slot : cache) {
+    if (slot.instance != instance_)
+      continue;
+    if (slot.version != v) {
+      slot.table = table_.load(std::memory_order_acquire);
+      slot.version = v;
+    }
+    return *slot.table;
+  }
+  // First read from this directory on this thread. Slots of directories
+  // destroyed since would otherwise keep their tables until thread exit.
+  std::erase_if(cache, [](const CacheSlot &s) { return s.alive.expired(); });
+  cache.push_back(
+      {instance_, v, alive_, table_.load(std::memory_order_acquire)});
+  return *cache.back().table;
+}
+
+std::shared_ptr<const GameTable> GameDirectory::snapshot() const {
+  return table_.load(std::memory_order_acquire);
+}
+
+bool GameDirectory::refresh() {
+  auto doc = client_.get_games();
+  if (!doc)
+    return false;
+  auto games = Game::list_from_json(*doc);
+  if (games.empty())
+    return false; // error document or an empty answer; keep what we have
+
+  table_.store(std::make_shared<const GameTable>(std::move(games)),
+               std::memory_order_release);
+  version_.fetch_add(1, std::memory_order_release);
+  {
+    // Pairs with wait_ready()'s predicate check so the wakeup isn't lost.
+    std::lock_guard<std::mutex> l(mutex_);
+  }
+  cv_.notify_all();
+  return true;
+}
+
+bool GameDirectory::wait_ready(std::chrono::milliseconds timeout) const {
+  std::unique_lock<std::mutex> l(mutex_);
+  return cv_.wait_for(l, timeout, [&] {
+    return version_.load(std::memory_order_acquire) > 0;
+  });
+}
+
+void GameDirectory::run(std::chrono::seconds interval) {
+  std::unique_lock<std::mutex> l(mutex_);
+  while (!stop_) {
+    l.unlock();
+    refresh();
+    l.lock();
+    cv_.wait_for(l, interval, [&] { return stop_; });
+  }
+}
+
+} // namespace nexusmods
@@ -0,0 +1,156 @@
+#include "nexusmods/happy_eyeballs.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace nexusmods {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Candidate {
+  sockaddr_storage addr{};
+  socklen_t len = 0;
+  int family = 0;
+};
+
+// Alternate address families, keeping the resolver's order within each.
+std::vector<Candidate> interleave(const addrinfo *res) {
+  std::vector<Candidate> first, second;
+  int preferred = res ? res->ai_family : 0;
+  for (auto *ai = res; ai; ai = ai->ai_next) {
+    if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6)
+      continue;
+    Candidate c;
+    std::memcpy(&c.addr, ai->ai_addr, ai->ai_addrlen);
+    c.len = static_cast<socklen_t>(ai->ai_addrlen);
+    c.family = ai->ai_family;
+    (ai->ai_family == preferred ? first : second).push_back(c);
+  }
+  std::vector<Candidate> out;
+  out.reserve(first.size() + second.size());
+  for (size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+    if (i < first.size())
+      out.push_back(first[i]);
+    if (i < second.size())
+      out.push_back(second[i]);
+  }
+  return out;
+}
+
+std::string numeric_host(const Candidate &c) {
+  char buf[NI_MAXHOST];
+  if (getnameinfo(reinterpret_cast<const sockaddr *>(&c.addr), c.len, buf,
+                  sizeof(buf), nullptr, 0, NI_NUMERICHOST) != 0)
+    return std::string();
+  return buf;
+}
+
+struct Attempt {
+  int fd;
+  size_t candidate;
+};
+
+} // namespace
+
+std::optional<RacedConnection> race_connect(const std::string &host, int port,
+                                            std::chrono::milliseconds timeout,
+                                            std::chrono::milliseconds stagger) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) !=
+      0)
+    return std::nullopt;
+  std::vector<Candidate> candidates = interleave(res);
+  freeaddrinfo(res);
+
+  const auto deadline = Clock::now() + timeout;
+  auto next_start = Clock::now();
+  size_t next = 0;
+  std::vector<Attempt> attempts;
+  std::optional<RacedConnection> winner;
+
+  auto win = [&](int fd, size_t candidate) {
+    winner = RacedConnection{fd, numeric_host(candidates[candidate]),
+                             candidates[candidate].family};
+  };
+
+  while (!winner) {
+    auto now = Clock::now();
+    if (now >= deadline)
+      break;
+
+    // Start the next attempt when its turn comes, or right away if nothing
+    // is in flight.
+    if (next < candidates.size() && (now >= next_start || attempts.empty())) {
+      const Candidate &c = candidates[next];
+      int fd = ::socket(c.family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (fd >= 0) {
+        int rc = ::connect(fd, reinterpret_cast<const sockaddr *>(&c.addr),
+                           c.len);
+        if (rc == 0) {
+          win(fd, next);
+          break;
+        }
+        if (errno == EINPROGRESS)
+          attempts.push_back({fd, next});
+        else
+          ::close(fd);
+      }
+      ++next;
+      next_start = Clock::now() + stagger;
+      continue;
+    }
+    if (attempts.empty())
+      break; // every address failed
+
+    auto until = deadline;
+    if (next < candidates.size())
+      until = std::min(until, next_start);
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        until - Clock::now());
+    std::vector<pollfd> fds;
+    fds.reserve(attempts.size());
+    for (const auto &a : attempts)
+      fds.push_back({a.fd, POLLOUT, 0});
+    int n = ::poll(fds.data(), fds.size(),
+                   static_cast<int>(std::max<int64_t>(wait.count(), 0)));
+    if (n <= 0)
+      continue; // timer expired (or EINTR): maybe start the next attempt
+
+    std::vector<Attempt> still;
+    for (size_t i = 0; i < fds.size(); ++i) {
+      if (fds[i].revents == 0 || winner) {
+        still.push_back(attempts[i]);
+        continue;
+      }
+      int err = 0;
+      socklen_t len = sizeof(err);
+      ::getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &err, &len);
+      if (err == 0) {
+        win(fds[i].fd, attempts[i].candidate);
+      } else {
+        ::close(fds[i].fd);
+        next_start = Clock::now(); // a failure lets the next one go now
+      }
+    }
+    attempts.swap(still);
+  }
+
+  for (const auto &a : attempts)
+    ::close(a.fd);
+  return winner;
+}
+
+} // namespace nexusmods
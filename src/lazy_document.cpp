@@ -0,0 +1,260 @@
+#include "nexusmods/lazy_document.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace nexusmods {
+
+namespace {
+
+bool is_ws(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+bool is_delim(char c) {
+  return is_ws(c) || c == ',' || c == ':' || c == ']' || c == '}';
+}
+
+} // namespace
+
+LazyDocument::LazyDocument(std::string body) : body_(std::move(body)) {
+  build_index();
+}
+
+// Single pass over the body recording one token per value. Containers are
+// closed by patching their end/next once the matching bracket is seen, which
+// lets lookups hop over whole subtrees.
+void LazyDocument::build_index() {
+  tokens_.clear();
+  tokens_.reserve(body_.size() / 8 + 1);
+  std::vector<uint32_t> open;   // unclosed containers
+  std::vector<uint32_t> counts; // direct children seen for each of them
+
+  const char *s = body_.data();
+  const size_t n = body_.size();
+  size_t i = 0;
+  auto fail = [&](size_t at) {
+    error_offset_ = at;
+    tokens_.clear();
+  };
+
+  while (i < n) {
+    char c = s[i];
+    if (is_ws(c) || c == ',' || c == ':') {
+      ++i;
+      continue;
+    }
+    auto idx = static_cast<uint32_t>(tokens_.size());
+    if (c == '}' || c == ']') {
+      // Objects must hold key/value pairs; checking here keeps lookups from
+      // running off the end of a truncated object.
+      if (open.empty() || tokens_[open.back()].type != (c == '}' ? '{' : '[') ||
+          (c == '}' && counts.back() % 2 != 0))
+        return fail(i);
+      Token &t = tokens_[open.back()];
+      open.pop_back();
+      counts.pop_back();
+      t.end = static_cast<uint32_t>(i + 1);
+      t.next = idx;
+      ++i;
+      continue;
+    }
+
+    if (open.empty() && !tokens_.empty())
+      return fail(i); // more than one root value
+    if (!open.empty()) {
+      bool key_slot = tokens_[open.back()].type == '{' && counts.back() % 2 == 0;
+      if (key_slot && c != '"')
+        return fail(i);
+      ++counts.back();
+    }
+
+    switch (c) {
+    case '{':
+    case '[':
+      tokens_.push_back({static_cast<uint32_t>(i), 0, 0, c});
+      open.push_back(idx);
+      counts.push_back(0);
+      ++i;
+      break;
+    case '"': {
+      size_t j = i + 1;
+      while (j < n && s[j] != '"')
+        j += s[j] == '\\' ? 2 : 1;
+      if (j >= n)
+        return fail(i);
+      tokens_.push_back(
+          {static_cast<uint32_t>(i), static_cast<uint32_t>(j + 1), idx + 1, c});
+      i = j + 1;
+      break;
+    }
+    default: {
+      size_t j = i;
+      while (j < n && !is_delim(s[j]))
+        ++j;
+      char type = (c == 't' || c == 'f' || c == 'n') ? c : '0';
+      tokens_.push_back(
+          {static_cast<uint32_t>(i), static_cast<uint32_t>(j), idx + 1, type});
+      i = j;
+      break;
+    }
+    }
+  }
+
+  if (!open.empty())
+    return fail(tokens_[open.back()].begin);
+  if (tokens_.empty())
+    return fail(0);
+}
+
+LazyValue LazyDocument::root() const {
+  if (tokens_.empty())
+    return LazyValue();
+  return LazyValue(this, 0);
+}
+
+LazyValue::Kind LazyValue::kind() const {
+  if (!doc_)
+    return Kind::Missing;
+  switch (doc_->tokens_[token_].type) {
+  case '{':
+    return Kind::Object;
+  case '[':
+    return Kind::Array;
+  case '"':
+    return Kind::String;
+  case 't':
+  case 'f':
+    return Kind::Bool;
+  case 'n':
+    return Kind::Null;
+  default:
+    return Kind::Number;
+  }
+}
+
+LazyValue LazyValue::operator[](std::string_view key) const {
+  if (!is_object())
+    return LazyValue();
+  const auto &tokens = doc_->tokens_;
+  const uint32_t end = tokens[token_].next;
+  for (uint32_t k = token_ + 1; k < end; k = tokens[k + 1].next) {
+    const auto &t = tokens[k];
+    std::string_view name(doc_->body_.data() + t.begin + 1, t.end - t.begin - 2);
+    if (name == key)
+      return LazyValue(doc_, k + 1);
+    // Escaped keys are rare; decode only when the raw bytes can't match.
+    if (name.find('\\') != std::string_view::npos &&
+        LazyValue(doc_, k).get_string() == key)
+      return LazyValue(doc_, k + 1);
+  }
+  return LazyValue();
+}
+
+LazyValue LazyValue::operator[](size_t index) const {
+  if (!is_array())
+    return LazyValue();
+  const auto &tokens = doc_->tokens_;
+  const uint32_t end = tokens[token_].next;
+  for (uint32_t k = token_ + 1; k < end; k = tokens[k].next) {
+    if (index-- == 0)
+      return LazyValue(doc_, k);
+  }
+  return LazyValue();
+}
+
+size_t LazyValue::size() const {
+  Kind k = kind();
+  if (k != Kind::Object && k != Kind::Array)
+    return 0;
+  const auto &tokens = doc_->tokens_;
+  const uint32_t end = tokens[token_].next;
+  size_t count = 0;
+  for (uint32_t t = token_ + 1; t < end; t = tokens[t].next)
+    ++count;
+  return k == Kind::Object ? count / 2 : count;
+}
+
+std::string_view LazyValue::raw() const {
+  if (!doc_)
+    return {};
+  const auto &t = doc_->tokens_[token_];
+  return std::string_view(doc_->body_.data() + t.begin, t.end - t.begin);
+}
+
+std::optional<bool> LazyValue::get_bool() const {
+  auto r = raw();
+  if (r == "true")
+    return true;
+  if (r == "false")
+    return false;
+  return std::nullopt;
+}
+
+std::optional<int64_t> LazyValue::get_int64() const {
+  if (kind() != Kind::Number)
+    return std::nullopt;
+  auto r = raw();
+  int64_t v = 0;
+  auto [p, ec] = std::from_chars(r.data(), r.data() + r.size(), v);
+  if (ec != std::errc() || p != r.data() + r.size())
+    return std::nullopt;
+  return v;
+}
+
+std::optional<double> LazyValue::get_double() const {
+  if (kind() != Kind::Number)
+    return std::nullopt;
+  auto r = raw();
+  double v = 0;
+  auto [p, ec] = std::from_chars(r.data(), r.data() + r.size(), v);
+  if (ec != std::errc() || p != r.data() + r.size())
+    return std::nullopt;
+  return v;
+}
+
+std::optional<std::string> LazyValue::get_string() const {
+  if (kind() != Kind::String)
+    return std::nullopt;
+  auto r = raw();
+  auto content = r.substr(1, r.size() - 2);
+  if (content.find('\\') == std::string_view::npos)
+    return std::string(content);
+
+  // Let RapidJSON deal with escapes and surrogate pairs.
+  rapidjson::Document d;
+  d.Parse(r.data(), r.size());
+  if (d.HasParseError() || !d.IsString())
+    return std::nullopt;
+  return std::string(d.GetString(), d.GetStringLength());
+}
+
+rapidjson::Document LazyValue::materialize() const {
+  rapidjson::Document d;
+  auto r = raw();
+  if (r.empty())
+    d.SetNull();
+  else
+    d.Parse(r.data(), r.size());
+  return d;
+}
+
+LazyValue::Range<LazyValue> LazyValue::elements() const {
+  using It = Range<LazyValue>::iterator;
+  if (!is_array())
+    return Range<LazyValue>(It(), It());
+  return Range<LazyValue>(It(doc_, token_ + 1),
+                          It(doc_, doc_->tokens_[token_].next));
+}
+
+LazyValue::Range<std::pair<LazyValue, LazyValue>> LazyValue::members() const {
+  using R = Range<std::pair<LazyValue, LazyValue>>;
+  if (!is_object())
+    return R(R::iterator(), R::iterator());
+  return R(R::iterator(doc_, token_ + 1),
+           R::iterator(doc_, doc_->tokens_[token_].next));
+}
+
+uint32_t LazyValue::skip(const LazyDocument *doc, uint32_t token) {
+  return doc->tokens_[token].next;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,204 @@
+#include "nexusmods/logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+namespace nexusmods {
+
+namespace {
+
+std::atomic<uint64_t> next_logger_id{1};
+
+constexpr size_t kCacheLine = 64;
+
+} // namespace
+
+std::string_view to_string(LogEvent event) {
+  switch (event) {
+  case LogEvent::RequestStart:
+    return "request_start";
+  case LogEvent::RequestDone:
+    return "request_done";
+  case LogEvent::Retry:
+    return "retry";
+  case LogEvent::Backoff:
+    return "backoff";
+  }
+  return "unknown";
+}
+
+// Single producer (the owning thread), single consumer (the drain thread).
+struct Logger::Ring {
+  Ring(size_t capacity, uint64_t thread_hash) : thread(thread_hash) {
+    size_t cap = 2;
+    while (cap < capacity)
+      cap <<= 1;
+    mask = cap - 1;
+    slots = std::make_unique<LogRecord[]>(cap);
+  }
+
+  std::unique_ptr<LogRecord[]> slots;
+  size_t mask = 0;
+  const uint64_t thread;
+  alignas(kCacheLine) std::atomic<size_t> head{0}; // next slot to write
+  alignas(kCacheLine) std::atomic<size_t> tail{0}; // next slot to read
+  std::atomic<bool> producer_gone{false};          // owning thread exited
+  std::atomic<bool> logger_gone{false};
+};
+
+Logger::Logger(Sink sink, size_t ring_capacity,
+               std::chrono::milliseconds drain_interval)
+    : id_(next_logger_id.fetch_add(1, std::memory_order_relaxed)),
+      ring_capacity_(ring_capacity), drain_interval_(drain_interval),
+      sink_(std::move(sink)) {
+  drainer_ = std::thread([this] { run(); });
+}
+
+Logger::~Logger() {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  drainer_.join();
+  std::lock_guard<std::mutex> l(rings_mutex_);
+  for (auto &ring : rings_)
+    ring->logger_gone.store(true, std::memory_order_release);
+}
+
+// Threads keep a short list of (logger, ring) pairs; the lookup is a scan of
+// that list, and only a thread's first record for a logger takes a lock.
+Logger::Ring &Logger::ring_for_this_thread() {
+  struct Entry {
+    uint64_t logger;
+    std::shared_ptr<Ring> ring;
+  };
+  struct ThreadRings {
+    std::vector<Entry> entries;
+    ~ThreadRings() {
+      for (auto &e : entries)
+        e.ring->producer_gone.store(true, std::memory_order_release);
+    }
+  };
+  thread_local ThreadRings local;
+
+  for (auto &e : local.entries)
+    if (e.logger == id_)
+      return *e.ring;
+
+  std::erase_if(local.entries, [](const Entry &e) {
+    return e.ring->logger_gone.load(std::memory_order_acquire);
+  });
+  auto ring = std::make_shared<Ring>(
+      ring_capacity_, std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::lock_guard<std::mutex> l(rings_mutex_);
+    rings_.push_back(ring);
+  }
+  local.entries.push_back({id_, ring});
+  return *ring;
+}
+
+void Logger::log(const LogRecord &record) {
+  Ring &ring = ring_for_this_thread();
+  size_t head = ring.head.load(std::memory_order_relaxed);
+  if (head - ring.tail.load(std::memory_order_acquire) > ring.mask) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  LogRecord &slot = ring.slots[head & ring.mask];
+  slot = record;
+  slot.thread = ring.thread;
+  ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Logger::log(LogEvent event, std::string_view path, int32_t status,
+                 int32_t attempt, int64_t value) {
+  LogRecord r;
+  r.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::system_clock::now().time_since_epoch())
+                  .count();
+  r.event = event;
+  r.status = status;
+  r.attempt = attempt;
+  r.value = value;
+  size_t n = std::min(path.size(), sizeof(r.path) - 1);
+  std::memcpy(r.path, path.data(), n);
+  r.path[n] = '\0';
+  log(r);
+}
+
+void Logger::flush() {
+  std::unique_lock<std::mutex> l(mutex_);
+  uint64_t ticket = ++flush_requested_;
+  cv_.notify_all();
+  cv_.wait(l, [&] { return flush_done_ >= ticket; });
+}
+
+void Logger::run() {
+  std::vector<LogRecord> batch;
+  std::unique_lock<std::mutex> l(mutex_);
+  for (;;) {
+    cv_.wait_for(l, drain_interval_, [&] {
+      return stop_ || flush_requested_ != flush_done_;
+    });
+    uint64_t target = flush_requested_;
+    bool stopping = stop_;
+    l.unlock();
+    drain_once(batch);
+    l.lock();
+    flush_done_ = target;
+    cv_.notify_all();
+    if (stopping)
+      return;
+  }
+}
+
+void Logger::drain_once(std::vector<LogRecord> &batch) {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> l(rings_mutex_);
+    rings = rings_;
+  }
+
+  batch.clear();
+  for (auto &ring : rings) {
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    size_t head = ring->head.load(std::memory_order_acquire);
+    for (size_t i = tail; i != head; ++i)
+      batch.push_back(ring->slots[i & ring->mask]);
+    ring->tail.store(head, std::memory_order_release);
+  }
+  if (!batch.empty()) {
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const LogRecord &a, const LogRecord &b) {
+                       return a.time_ns < b.time_ns;
+                     });
+    sink_(batch.data(), batch.size());
+  }
+
+  // Forget rings whose thread has exited once they are empty. The flag is
+  // set after the thread's last push, so checking it first makes the
+  // emptiness test final.
+  std::lock_guard<std::mutex> l(rings_mutex_);
+  std::erase_if(rings_, [](const std::shared_ptr<Ring> &ring) {
+    return ring->producer_gone.load(std::memory_order_acquire) &&
+           ring->head.load(std::memory_order_acquire) ==
+               ring->tail.load(std::memory_order_relaxed);
+  });
+}
+
+Logger::Sink Logger::text_sink(std::ostream &out) {
+  return [&out](const LogRecord *records, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      const LogRecord &r = records[i];
+      out << r.time_ns << ' ' << r.thread << ' ' << to_string(r.event) << ' '
+          << r.path << " status=" << r.status << " attempt=" << r.attempt
+          << " value=" << r.value << '\n';
+    }
+    out.flush();
+  };
+}
+
+} // namespace nexusmods
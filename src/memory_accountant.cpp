@@ -0,0 +1,174 @@
+#include "nexusmods/memory_accountant.h"
+
+#include <algorithm>
+
+namespace nexusmods {
+
+MemoryReservation::MemoryReservation(MemoryReservation &&o) noexcept
+    : owner_(std::move(o.owner_)), id_(o.id_), bytes_(o.bytes_) {
+  o.bytes_ = 0;
+}
+
+MemoryReservation &
+MemoryReservation::operator=(MemoryReservation &&o) noexcept {
+  if (this != &o) {
+    reset();
+    owner_ = std::move(o.owner_);
+    id_ = o.id_;
+    bytes_ = o.bytes_;
+    o.bytes_ = 0;
+  }
+  return *this;
+}
+
+void MemoryReservation::reset() {
+  if (owner_ && bytes_)
+    owner_->release(id_, bytes_);
+  owner_.reset();
+  bytes_ = 0;
+}
+
+MemoryAccountant::MemoryAccountant(size_t cap_bytes) : cap_(cap_bytes) {}
+
+MemoryAccountant::SubsystemId
+MemoryAccountant::register_subsystem(const std::string &name, Evictor evict) {
+  std::lock_guard<std::mutex> l(mutex_);
+  Subsystem s;
+  s.usage.name = name;
+  s.evict = std::move(evict);
+  subsystems_.push_back(std::move(s));
+  return subsystems_.size() - 1;
+}
+
+MemoryAccountant::SubsystemId
+MemoryAccountant::subsystem(const std::string &name) {
+  std::lock_guard<std::mutex> l(mutex_);
+  for (size_t i = 0; i < subsystems_.size(); ++i)
+    if (!subsystems_[i].evict && subsystems_[i].usage.name == name)
+      return i;
+  Subsystem s;
+  s.usage.name = name;
+  subsystems_.push_back(std::move(s));
+  return subsystems_.size() - 1;
+}
+
+void MemoryAccountant::add_locked(SubsystemId id, size_t bytes) {
+  auto &u = subsystems_[id].usage;
+  u.used += bytes;
+  u.peak = std::max(u.peak, u.used);
+  used_ += bytes;
+}
+
+MemoryReservation MemoryAccountant::charge(SubsystemId id, size_t bytes) {
+  std::lock_guard<std::mutex> l(mutex_);
+  add_locked(id, bytes);
+  return MemoryReservation(shared_from_this(), id, bytes);
+}
+
+bool MemoryAccountant::try_add(SubsystemId id, size_t bytes) {
+  for (int pass = 0; pass < 2; ++pass) {
+    size_t over = 0;
+    {
+      std::lock_guard<std::mutex> l(mutex_);
+      // A single allocation larger than the whole budget is let through
+      // when nothing else is held, otherwise it could never proceed.
+      if (used_ + bytes <= cap_ || used_ == 0) {
+        add_locked(id, bytes);
+        return true;
+      }
+      over = used_ + bytes - cap_;
+    }
+    if (pass == 0)
+      evict(over);
+  }
+  return false;
+}
+
+std::optional<MemoryReservation>
+MemoryAccountant::try_reserve(SubsystemId id, size_t bytes) {
+  if (!try_add(id, bytes))
+    return std::nullopt;
+  return MemoryReservation(shared_from_this(), id, bytes);
+}
+
+void MemoryAccountant::release(SubsystemId id, size_t bytes) {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    auto &u = subsystems_[id].usage;
+    bytes = std::min(bytes, u.used);
+    u.used -= bytes;
+    used_ -= bytes;
+  }
+  released_.notify_all();
+}
+
+void MemoryAccountant::evict(size_t bytes_wanted) {
+  std::vector<Evictor> evictors;
+  size_t goal = 0;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    goal = used_ > bytes_wanted ? used_ - bytes_wanted : 0;
+    for (auto &s : subsystems_)
+      if (s.evict && s.usage.used > 0)
+        evictors.push_back(s.evict);
+  }
+  for (auto &e : evictors) {
+    {
+      std::lock_guard<std::mutex> l(mutex_);
+      if (used_ <= goal)
+        return;
+      ++evictions_;
+    }
+    e(bytes_wanted);
+  }
+}
+
+bool MemoryAccountant::wait_for_headroom(
+    std::chrono::steady_clock::duration max_wait) {
+  auto deadline = std::chrono::steady_clock::now() + max_wait;
+  size_t over = 0;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    if (used_ < cap_)
+      return true;
+    over = used_ - cap_ + 1;
+    ++throttled_waits_;
+  }
+  evict(over);
+
+  std::unique_lock<std::mutex> l(mutex_);
+  return released_.wait_until(l, deadline, [&] { return used_ < cap_; });
+}
+
+void MemoryAccountant::set_cap(size_t cap_bytes) {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    cap_ = cap_bytes;
+  }
+  released_.notify_all();
+}
+
+size_t MemoryAccountant::cap() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return cap_;
+}
+
+size_t MemoryAccountant::used() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return used_;
+}
+
+MemoryAccountant::Snapshot MemoryAccountant::snapshot() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  Snapshot s;
+  s.cap = cap_;
+  s.used = used_;
+  s.evictions = evictions_;
+  s.throttled_waits = throttled_waits_;
+  s.subsystems.reserve(subsystems_.size());
+  for (auto &sub : subsystems_)
+    s.subsystems.push_back(sub.usage);
+  return s;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,148 @@
+#include "nexusmods/mod_batcher.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "nexusmods/client.h"
+
+namespace nexusmods {
+
+ModBatcher::ModBatcher(Client &client) : ModBatcher(client, Options()) {}
+
+ModBatcher::ModBatcher(Client &client, Options options)
+    : client_(client), options_(options) {
+  size_t workers = std::max<size_t>(options_.max_parallel, 1);
+  if (options_.window.count() > 0)
+    collector_ = std::thread([this] { collect(); });
+  workers_.reserve(workers);
+  for (size_t i = 0; i < workers; ++i)
+    workers_.emplace_back([this] { work(); });
+}
+
+ModBatcher::~ModBatcher() {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    stop_ = true;
+  }
+  collector_cv_.notify_all();
+  if (collector_.joinable())
+    collector_.join(); // hands over its last window first
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    workers_stop_ = true;
+  }
+  worker_cv_.notify_all();
+  for (auto &t : workers_)
+    t.join();
+}
+
+std::future<std::optional<rapidjson::Document>>
+ModBatcher::get_mod_async(const std::string &game_domain_name,
+                          const std::string &mod_id) {
+  Promise promise;
+  auto result = promise.get_future();
+  bool wake_collector = false;
+  bool wake_worker = false;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    ++stats_.lookups;
+    Key key(game_domain_name, mod_id);
+    auto [it, fresh] = waiters_.try_emplace(key);
+    it->second.push_back(std::move(promise));
+    if (!fresh) {
+      ++stats_.deduplicated;
+    } else if (collector_.joinable()) {
+      if (window_.empty())
+        window_end_ = std::chrono::steady_clock::now() + options_.window;
+      window_.push_back(std::move(key));
+      // The first lookup opens a window; a full batch closes it early.
+      wake_collector =
+          window_.size() == 1 || window_.size() >= options_.max_batch;
+    } else {
+      jobs_.push_back(std::move(key));
+      wake_worker = true;
+    }
+  }
+  if (wake_collector)
+    collector_cv_.notify_one();
+  if (wake_worker)
+    worker_cv_.notify_one();
+  return result;
+}
+
+std::optional<rapidjson::Document>
+ModBatcher::get_mod(const std::string &game_domain_name,
+                    const std::string &mod_id) {
+  return get_mod_async(game_domain_name, mod_id).get();
+}
+
+ModBatcher::Stats ModBatcher::stats() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return stats_;
+}
+
+void ModBatcher::collect() {
+  std::unique_lock<std::mutex> l(mutex_);
+  for (;;) {
+    collector_cv_.wait(l, [&] { return stop_ || !window_.empty(); });
+    if (!stop_)
+      collector_cv_.wait_until(l, window_end_, [&] {
+        return stop_ || window_.size() >= options_.max_batch;
+      });
+    if (!window_.empty()) {
+      ++stats_.batches;
+      jobs_.insert(jobs_.end(), std::make_move_iterator(window_.begin()),
+                   std::make_move_iterator(window_.end()));
+      window_.clear();
+      worker_cv_.notify_all();
+    }
+    if (stop_)
+      return;
+  }
+}
+
+void ModBatcher::work() {
+  std::unique_lock<std::mutex> l(mutex_);
+  for (;;) {
+    worker_cv_.wait(l, [&] { return !jobs_.empty() || workers_stop_; });
+    if (jobs_.empty())
+      return;
+    Key key = std::move(jobs_.front());
+    jobs_.pop_front();
+    ++stats_.fetches;
+    l.unlock();
+
+    std::optional<rapidjson::Document> doc;
+    std::exception_ptr error;
+    try {
+      doc = client_.get_mod(key.first, key.second);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    // Lookups that joined while the request was out get its result too.
+    l.lock();
+    auto node = waiters_.extract(key);
+    l.unlock();
+    auto &waiters = node.mapped();
+    for (size_t i = 1; i < waiters.size(); ++i) {
+      if (error) {
+        waiters[i].set_exception(error);
+      } else if (!doc) {
+        waiters[i].set_value(std::nullopt);
+      } else {
+        rapidjson::Document copy;
+        copy.CopyFrom(*doc, copy.GetAllocator());
+        waiters[i].set_value(std::move(copy));
+      }
+    }
+    if (error)
+      waiters[0].set_exception(error);
+    else
+      waiters[0].set_value(std::move(doc));
+
+    l.lock();
+  }
+}
+
+} // namespace nexusmods
@@ -0,0 +1,44 @@
+#include "nexusmods/parse_pool.h"
+
+namespace nexusmods {
+
+ParsePool::ParsePool(size_t threads, size_t queue_capacity)
+    : queue_(queue_capacity) {
+  if (threads == 0)
+    threads = 1;
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i)
+    workers_.emplace_back([this] { run(); });
+}
+
+ParsePool::~ParsePool() {
+  stop_.store(true, std::memory_order_release);
+  pending_.release(static_cast<std::ptrdiff_t>(workers_.size()));
+  for (auto &t : workers_)
+    t.join();
+}
+
+bool ParsePool::try_submit(std::function<void()> job) {
+  if (!queue_.try_push(std::move(job)))
+    return false;
+  pending_.release();
+  return true;
+}
+
+// Every release() stands for either one queued job or one stop request, so a
+// worker that wakes up either finds a job (possibly after a producer finishes
+// publishing it) or, once stopping and drained, exits.
+void ParsePool::run() {
+  for (;;) {
+    pending_.acquire();
+    std::function<void()> job;
+    while (!queue_.try_pop(job)) {
+      if (stop_.load(std::memory_order_acquire) && queue_.empty())
+        return;
+      std::this_thread::yield();
+    }
+    job();
+  }
+}
+
+} // namespace nexusmods
@@ -0,0 +1,182 @@
+#include "nexusmods/projection.h"
+
+#include <vector>
+
+#include "rapidjson/reader.h"
+
+namespace nexusmods {
+
+FieldProjection::FieldProjection(std::initializer_list<std::string_view> paths) {
+  for (auto p : paths)
+    add(p);
+}
+
+FieldProjection &FieldProjection::add(std::string_view path) {
+  Node *node = &root_;
+  while (!path.empty()) {
+    if (node->whole)
+      return *this; // an ancestor is already kept in full
+    auto dot = path.find('.');
+    auto key = path.substr(0, dot);
+    path = dot == std::string_view::npos ? std::string_view()
+                                         : path.substr(dot + 1);
+    auto it = node->children.find(key);
+    if (it == node->children.end())
+      it = node->children.emplace(std::string(key), Node()).first;
+    node = &it->second;
+  }
+  node->whole = true;
+  node->children.clear();
+  return *this;
+}
+
+namespace {
+
+// SAX handler forwarding projected events into a Document and dropping the
+// rest. Skipped containers are tracked by depth only.
+class ProjectingHandler {
+public:
+  using Node = FieldProjection::Node;
+
+  ProjectingHandler(const Node &root, rapidjson::Document &out)
+      : out_(out), next_(root.whole ? nullptr : &root) {
+    frames_.reserve(16);
+  }
+
+  bool Null() {
+    return value([&] { return out_.Null(); });
+  }
+  bool Bool(bool b) {
+    return value([&] { return out_.Bool(b); });
+  }
+  bool Int(int i) {
+    return value([&] { return out_.Int(i); });
+  }
+  bool Uint(unsigned u) {
+    return value([&] { return out_.Uint(u); });
+  }
+  bool Int64(int64_t i) {
+    return value([&] { return out_.Int64(i); });
+  }
+  bool Uint64(uint64_t u) {
+    return value([&] { return out_.Uint64(u); });
+  }
+  bool Double(double d) {
+    return value([&] { return out_.Double(d); });
+  }
+  bool RawNumber(const char *str, rapidjson::SizeType len, bool) {
+    return value([&] { return out_.RawNumber(str, len, true); });
+  }
+  // In-situ parsing hands us pointers into the response body, so strings
+  // that survive the projection are always copied into the document.
+  bool String(const char *str, rapidjson::SizeType len, bool) {
+    return value([&] { return out_.String(str, len, true); });
+  }
+
+  bool StartObject() { return open(false); }
+  bool StartArray() { return open(true); }
+  bool EndObject(rapidjson::SizeType) { return close(false); }
+  bool EndArray(rapidjson::SizeType) { return close(true); }
+
+  bool Key(const char *str, rapidjson::SizeType len, bool) {
+    if (skip_depth_ > 0)
+      return true;
+    Frame &f = frames_.back();
+    if (f.node) {
+      auto it = f.node->children.find(std::string_view(str, len));
+      if (it == f.node->children.end()) {
+        skip_next_ = true;
+        return true;
+      }
+      next_ = it->second.whole ? nullptr : &it->second;
+    } else {
+      next_ = nullptr;
+    }
+    ++f.count;
+    return out_.Key(str, len, true);
+  }
+
+private:
+  struct Frame {
+    const Node *node; // nullptr: keep everything below
+    bool array;
+    rapidjson::SizeType count; // members/elements forwarded so far
+  };
+
+  // Projection node for the value about to start. Arrays pass their own
+  // node down to every element.
+  const Node *target() const {
+    if (!frames_.empty() && frames_.back().array)
+      return frames_.back().node;
+    return next_;
+  }
+
+  template <typename F> bool value(F &&forward) {
+    if (skip_depth_ > 0)
+      return true;
+    if (skip_next_) {
+      skip_next_ = false;
+      return true;
+    }
+    if (!frames_.empty() && frames_.back().array)
+      ++frames_.back().count;
+    return forward();
+  }
+
+  bool open(bool array) {
+    if (skip_depth_ > 0) {
+      ++skip_depth_;
+      return true;
+    }
+    if (skip_next_) {
+      skip_next_ = false;
+      skip_depth_ = 1;
+      return true;
+    }
+    const Node *node = target();
+    if (!frames_.empty() && frames_.back().array)
+      ++frames_.back().count;
+    frames_.push_back({node, array, 0});
+    return array ? out_.StartArray() : out_.StartObject();
+  }
+
+  bool close(bool array) {
+    if (skip_depth_ > 0) {
+      --skip_depth_;
+      return true;
+    }
+    rapidjson::SizeType count = frames_.back().count;
+    frames_.pop_back();
+    return array ? out_.EndArray(count) : out_.EndObject(count);
+  }
+
+  rapidjson::Document &out_;
+  const Node *next_;
+  std::vector<Frame> frames_;
+  int skip_depth_ = 0;
+  bool skip_next_ = false;
+};
+
+} // namespace
+
+rapidjson::ParseResult parse_projected(std::string &json,
+                                       const FieldProjection &projection,
+                                       rapidjson::Document &out) {
+  if (projection.empty()) {
+    out.Parse(json.c_str(), json.size());
+    return rapidjson::ParseResult(out.GetParseError(), out.GetErrorOffset());
+  }
+
+  rapidjson::ParseResult result;
+  auto generator = [&](rapidjson::Document &doc) {
+    ProjectingHandler handler(projection.root(), doc);
+    rapidjson::InsituStringStream stream(json.data());
+    rapidjson::Reader reader;
+    result = reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+    return !result.IsError();
+  };
+  out.Populate(generator);
+  return result;
+}
+
+} // namespace nexusmods
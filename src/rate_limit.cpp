@@ -0,0 +1,295 @@
+#include "nexusmods/rate_limit.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace nexusmods {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// Servers round resets to the second; wait a little past them.
+constexpr auto kResetSlack = std::chrono::seconds(1);
+
+milliseconds until(RateLimitState::TimePoint t, RateLimitState::TimePoint now) {
+  if (t <= now)
+    return milliseconds(0);
+  return std::chrono::ceil<milliseconds>(t - now);
+}
+
+milliseconds until_reset(const RateLimitState &s,
+                         RateLimitState::TimePoint now) {
+  return until(s.next_reset() + kResetSlack, now);
+}
+
+std::optional<int64_t> header_int(const httplib::Headers &headers,
+                                  const char *name) {
+  auto it = headers.find(name);
+  if (it == headers.end())
+    return std::nullopt;
+  try {
+    return std::stoll(it->second);
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+// Move `reset` forward by whole periods until it is in the future.
+template <typename Period>
+bool roll(RateLimitState::TimePoint &reset, RateLimitState::TimePoint now,
+          Period period) {
+  if (reset == RateLimitState::TimePoint() || reset > now)
+    return false;
+  auto periods = (now - reset) / period + 1;
+  reset += periods * period;
+  return true;
+}
+
+} // namespace
+
+std::optional<std::chrono::system_clock::time_point>
+parse_rate_limit_date(const std::string &date) {
+  std::tm tm = {};
+  std::istringstream ss(date);
+
+  // Try RFC 1123: "Wed, 21 Oct 2015 07:28:00 GMT"
+  ss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+  if (!ss.fail())
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+
+  // Try ISO: "2019-02-02 00:00:00 +0000"
+  ss.clear();
+  ss.str(date);
+  ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+  if (!ss.fail())
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+
+  // Try ISO with T: "2019-02-02T00:00:00"
+  ss.clear();
+  ss.str(date);
+  ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+  if (!ss.fail())
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+
+  return std::nullopt;
+}
+
+int64_t RateLimitState::available() const {
+  return daily_remaining > 0 ? daily_remaining : hourly_remaining;
+}
+
+RateLimitState::TimePoint RateLimitState::next_reset() const {
+  return daily_remaining > 0 ? daily_reset : hourly_reset;
+}
+
+milliseconds BurstPacing::delay(const RateLimitState &state,
+                                RateLimitState::TimePoint now,
+                                Priority) const {
+  if (!state.known || state.available() > 0)
+    return milliseconds(0);
+  return until_reset(state, now);
+}
+
+milliseconds EvenPacing::delay(const RateLimitState &state,
+                               RateLimitState::TimePoint now, Priority) const {
+  if (!state.known)
+    return milliseconds(0);
+  int64_t left = state.available();
+  if (left <= 0)
+    return until_reset(state, now);
+  auto window = state.next_reset() - now;
+  if (window <= window.zero())
+    return milliseconds(0);
+  return until(state.last_sent + window / left, now);
+}
+
+PriorityPacing::PriorityPacing(double reserve,
+                               std::shared_ptr<PacingPolicy> bulk,
+                               std::shared_ptr<PacingPolicy> interactive)
+    : reserve_(std::clamp(reserve, 0.0, 1.0)), bulk_(std::move(bulk)),
+      interactive_(std::move(interactive)) {}
+
+milliseconds PriorityPacing::delay(const RateLimitState &state,
+                                   RateLimitState::TimePoint now,
+                                   Priority priority) const {
+  if (priority == Priority::Interactive || !state.known)
+    return interactive_ ? interactive_->delay(state, now, priority)
+                        : milliseconds(0);
+
+  bool daily = state.daily_remaining > 0;
+  int64_t limit = daily ? state.daily_limit : state.hourly_limit;
+  int64_t left = state.available() -
+                 static_cast<int64_t>(std::ceil(reserve_ * double(limit)));
+  if (left <= 0)
+    return until_reset(state, now);
+  if (!bulk_)
+    return milliseconds(0);
+  RateLimitState above = state;
+  (daily ? above.daily_remaining : above.hourly_remaining) = left;
+  return bulk_->delay(above, now, priority);
+}
+
+RateLimitBudget::RateLimitBudget(std::shared_ptr<PacingPolicy> policy,
+                                 NowFn now)
+    : policy_(std::move(policy)), now_(std::move(now)) {
+  if (!now_)
+    now_ = [] { return Clock::now(); };
+}
+
+void RateLimitBudget::observe(const httplib::Headers &headers) {
+  auto hourly_limit = header_int(headers, "X-RL-Hourly-Limit");
+  auto hourly_remaining = header_int(headers, "X-RL-Hourly-Remaining");
+  auto daily_limit = header_int(headers, "X-RL-Daily-Limit");
+  auto daily_remaining = header_int(headers, "X-RL-Daily-Remaining");
+  if (!hourly_remaining && !daily_remaining)
+    return;
+
+  RateLimitState reported;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    reported = state_;
+  }
+  auto reset = [&](const char *name, RateLimitState::TimePoint &out) {
+    auto it = headers.find(name);
+    if (it == headers.end())
+      return;
+    if (auto t = parse_rate_limit_date(it->second))
+      out = *t;
+  };
+  if (hourly_limit)
+    reported.hourly_limit = *hourly_limit;
+  if (hourly_remaining)
+    reported.hourly_remaining = *hourly_remaining;
+  if (daily_limit)
+    reported.daily_limit = *daily_limit;
+  if (daily_remaining)
+    reported.daily_remaining = *daily_remaining;
+  reset("X-RL-Hourly-Reset", reported.hourly_reset);
+  reset("X-RL-Daily-Reset", reported.daily_reset);
+  observe(reported);
+}
+
+// Responses to concurrent requests can arrive out of order; within one
+// window the lowest remaining count is the most recent.
+void RateLimitBudget::observe(const RateLimitState &reported) {
+  std::lock_guard<std::mutex> l(mutex_);
+  auto now = now_();
+  state_locked(now);
+  RateLimitState next = reported;
+  next.known = true;
+  next.last_sent = state_.last_sent;
+  if (state_.known) {
+    if (next.hourly_reset == state_.hourly_reset)
+      next.hourly_remaining =
+          std::min(next.hourly_remaining, state_.hourly_remaining);
+    if (next.daily_reset == state_.daily_reset)
+      next.daily_remaining =
+          std::min(next.daily_remaining, state_.daily_remaining);
+  }
+  state_ = next;
+}
+
+void RateLimitBudget::set_admission_options(AdmissionOptions options) {
+  std::lock_guard<std::mutex> l(mutex_);
+  admission_ = options;
+}
+
+double RateLimitBudget::Rate::at_time(Clock::time_point now,
+                                      double tau) const {
+  if (per_second == 0 || now <= at)
+    return per_second;
+  double dt = std::chrono::duration<double>(now - at).count();
+  return per_second * std::exp(-dt / tau);
+}
+
+void RateLimitBudget::on_sent(Priority priority) {
+  std::lock_guard<std::mutex> l(mutex_);
+  auto now = now_();
+  state_locked(now);
+  state_.last_sent = now;
+  // Each event adds 1/tau, so a steady rate r settles at r.
+  double tau = std::max<double>(double(admission_.rate_window.count()), 1);
+  Rate &rate = rates_[static_cast<size_t>(priority)];
+  rate.per_second = rate.at_time(now, tau) + 1 / tau;
+  rate.at = now;
+  if (!state_.known)
+    return;
+  state_.hourly_remaining = std::max<int64_t>(state_.hourly_remaining - 1, 0);
+  state_.daily_remaining = std::max<int64_t>(state_.daily_remaining - 1, 0);
+}
+
+milliseconds RateLimitBudget::delay(Priority priority) const {
+  if (!policy_)
+    return milliseconds(0);
+  std::lock_guard<std::mutex> l(mutex_);
+  auto now = now_();
+  return policy_->delay(state_locked(now), now, priority);
+}
+
+RateLimitForecast RateLimitBudget::forecast() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return forecast_locked(now_());
+}
+
+bool RateLimitBudget::may_spend(int64_t n, Priority priority) const {
+  std::lock_guard<std::mutex> l(mutex_);
+  auto now = now_();
+  if (!state_locked(now).known)
+    return true;
+  RateLimitForecast f = forecast_locked(now);
+  if (priority == Priority::Interactive)
+    return f.available >= n;
+  return f.available - n >= f.interactive_reserve;
+}
+
+RateLimitForecast
+RateLimitBudget::forecast_locked(Clock::time_point now) const {
+  const RateLimitState &s = state_locked(now);
+  double tau = std::max<double>(double(admission_.rate_window.count()), 1);
+  double interactive = rates_[0].at_time(now, tau);
+  double bulk = rates_[1].at_time(now, tau);
+
+  RateLimitForecast f;
+  f.interactive_per_hour = interactive * 3600;
+  f.bulk_per_hour = bulk * 3600;
+  f.available = s.available();
+  f.next_reset = s.next_reset();
+  double window =
+      s.known && f.next_reset > now
+          ? std::chrono::duration<double>(f.next_reset - now).count()
+          : 0;
+  f.left_at_reset = double(f.available) - (interactive + bulk) * window;
+  if (interactive + bulk > 0 && f.left_at_reset < 0)
+    f.exhausted_at =
+        now + std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(double(f.available) /
+                                                (interactive + bulk)));
+
+  int64_t limit = s.daily_remaining > 0 ? s.daily_limit : s.hourly_limit;
+  f.interactive_reserve = std::max(
+      static_cast<int64_t>(std::ceil(admission_.min_reserve * double(limit))),
+      static_cast<int64_t>(
+          std::ceil(admission_.demand_margin * interactive * window)));
+  return f;
+}
+
+RateLimitState RateLimitBudget::state() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return state_locked(now_());
+}
+
+// Apply resets that have passed since the last report.
+const RateLimitState &
+RateLimitBudget::state_locked(Clock::time_point now) const {
+  if (roll(state_.hourly_reset, now, std::chrono::hours(1)))
+    state_.hourly_remaining = state_.hourly_limit;
+  if (roll(state_.daily_reset, now, std::chrono::hours(24)))
+    state_.daily_remaining = state_.daily_limit;
+  return state_;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,38 @@
+#pragma once
+
+// Column descriptors for the catalog record sinks (SqliteSink and
+// CatalogExporter): a name plus the record field it reads. Each sink maps
+// the field type onto its own column type and writer.
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace nexusmods {
+
+template <typename R> struct RecordColumn {
+  std::string name;
+  std::variant<int64_t R::*, std::string R::*, bool R::*> field;
+};
+
+template <typename R> using RecordColumns = std::vector<RecordColumn<R>>;
+
+template <typename R, typename T>
+RecordColumn<R> column(const char *name, T R::*field) {
+  return {name, field};
+}
+
+// Calls `f(value)` with a reference to the column's field in `row`.
+template <typename R, typename F>
+decltype(auto) visit_field(const RecordColumn<R> &c, const R &row, F &&f) {
+  return std::visit([&](auto field) -> decltype(auto) { return f(row.*field); },
+                    c.field);
+}
+
+template <typename T, typename R>
+bool holds_field(const RecordColumn<R> &c) {
+  return std::holds_alternative<T R::*>(c.field);
+}
+
+} // namespace nexusmods
@@ -0,0 +1,226 @@
+#include "nexusmods/request_registry.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "httplib.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace nexusmods {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t to_ns(Clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             t.time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+const char *to_string(RequestState state) {
+  switch (state) {
+  case RequestState::WaitingForMemory:
+    return "waiting_for_memory";
+  case RequestState::WaitingForConnection:
+    return "waiting_for_connection";
+  case RequestState::InTransport:
+    return "in_transport";
+  case RequestState::ReadingBody:
+    return "reading_body";
+  case RequestState::BackingOff:
+    return "backing_off";
+  }
+  return "unknown";
+}
+
+// Written by the request thread, read by snapshot(); everything that changes
+// after registration is atomic.
+struct RequestTracker::Entry {
+  uint64_t id = 0;
+  size_t shard = 0;
+  std::string path;
+  Clock::time_point started;
+  std::atomic<uint8_t> state{static_cast<uint8_t>(RequestState::InTransport)};
+  std::atomic<int> attempt{0};
+  std::atomic<int64_t> wake_ns{0};
+};
+
+RequestTracker::RequestTracker(RequestTracker &&o) noexcept
+    : registry_(o.registry_), entry_(std::move(o.entry_)) {
+  o.registry_ = nullptr;
+}
+
+RequestTracker &RequestTracker::operator=(RequestTracker &&o) noexcept {
+  if (this != &o) {
+    if (registry_ && entry_)
+      registry_->untrack(*entry_);
+    registry_ = o.registry_;
+    entry_ = std::move(o.entry_);
+    o.registry_ = nullptr;
+  }
+  return *this;
+}
+
+RequestTracker::~RequestTracker() {
+  if (registry_ && entry_)
+    registry_->untrack(*entry_);
+}
+
+// Release, so a snapshot that reads the new state also sees the fields
+// written before it (wake_ns for BackingOff).
+void RequestTracker::set_state(RequestState state) {
+  if (entry_)
+    entry_->state.store(static_cast<uint8_t>(state),
+                        std::memory_order_release);
+}
+
+void RequestTracker::set_attempt(int attempt) {
+  if (entry_)
+    entry_->attempt.store(attempt, std::memory_order_relaxed);
+}
+
+void RequestTracker::backing_off(std::chrono::milliseconds sleep) {
+  if (!entry_)
+    return;
+  entry_->wake_ns.store(to_ns(Clock::now() + sleep),
+                        std::memory_order_relaxed);
+  set_state(RequestState::BackingOff);
+}
+
+RequestTracker RequestRegistry::track(const std::string &path) {
+  auto entry = std::make_shared<RequestTracker::Entry>();
+  entry->id = next_id_.fetch_add(1, std::memory_order_relaxed);
+  entry->shard = entry->id % kShards;
+  entry->path = path;
+  entry->started = Clock::now();
+  Shard &shard = shards_[entry->shard];
+  {
+    std::lock_guard<std::mutex> l(shard.mutex);
+    shard.entries.push_back(entry);
+  }
+  return RequestTracker(this, std::move(entry));
+}
+
+void RequestRegistry::untrack(const RequestTracker::Entry &entry) {
+  Shard &shard = shards_[entry.shard];
+  std::lock_guard<std::mutex> l(shard.mutex);
+  auto &v = shard.entries;
+  auto it = std::find_if(v.begin(), v.end(),
+                         [&](const auto &e) { return e.get() == &entry; });
+  if (it == v.end())
+    return;
+  *it = std::move(v.back());
+  v.pop_back();
+}
+
+std::vector<RequestRegistry::RequestInfo> RequestRegistry::snapshot() const {
+  std::vector<std::shared_ptr<RequestTracker::Entry>> entries;
+  for (const Shard &shard : shards_) {
+    std::lock_guard<std::mutex> l(shard.mutex);
+    entries.insert(entries.end(), shard.entries.begin(), shard.entries.end());
+  }
+
+  auto now = Clock::now();
+  std::vector<RequestInfo> out;
+  out.reserve(entries.size());
+  for (const auto &e : entries) {
+    RequestInfo info;
+    info.id = e->id;
+    info.path = e->path;
+    info.state =
+        static_cast<RequestState>(e->state.load(std::memory_order_acquire));
+    info.attempt = e->attempt.load(std::memory_order_relaxed);
+    info.elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - e->started);
+    if (info.state == RequestState::BackingOff) {
+      int64_t left = e->wake_ns.load(std::memory_order_relaxed) - to_ns(now);
+      info.wake_in = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::nanoseconds(std::max<int64_t>(left, 0)));
+    }
+    out.push_back(std::move(info));
+  }
+  std::sort(out.begin(), out.end(),
+            [](const RequestInfo &a, const RequestInfo &b) { return a.id < b.id; });
+  return out;
+}
+
+std::string RequestRegistry::to_json() const {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> w(sb);
+  w.StartArray();
+  for (const auto &r : snapshot()) {
+    w.StartObject();
+    w.Key("id");
+    w.Uint64(r.id);
+    w.Key("path");
+    w.String(r.path.c_str(), static_cast<rapidjson::SizeType>(r.path.size()));
+    w.Key("state");
+    w.String(to_string(r.state));
+    w.Key("attempt");
+    w.Int(r.attempt);
+    w.Key("elapsed");
+    w.Int64(r.elapsed.count());
+    w.Key("wake_in");
+    w.Int64(r.wake_in.count());
+    w.EndObject();
+  }
+  w.EndArray();
+  return std::string(sb.GetString(), sb.GetSize());
+}
+
+struct RequestDebugServer::Impl {
+  std::shared_ptr<RequestRegistry> registry;
+  httplib::Server server;
+  std::thread thread;
+};
+
+RequestDebugServer::RequestDebugServer(
+    std::shared_ptr<RequestRegistry> registry)
+    : impl_(std::make_unique<Impl>()) {
+  impl_->registry = std::move(registry);
+  RequestRegistry *reg = impl_->registry.get();
+  impl_->server.Get("/requests",
+                    [reg](const httplib::Request &, httplib::Response &res) {
+                      res.set_content(reg->to_json(), "application/json");
+                    });
+  impl_->server.Get("/", [reg](const httplib::Request &,
+                               httplib::Response &res) {
+    std::ostringstream out;
+    out << std::left << std::setw(8) << "id" << std::setw(20) << "state"
+        << std::setw(9) << "attempt" << std::setw(12) << "elapsed_ms"
+        << std::setw(12) << "wake_in_ms"
+        << "path\n";
+    for (const auto &r : reg->snapshot())
+      out << std::setw(8) << r.id << std::setw(20) << to_string(r.state)
+          << std::setw(9) << r.attempt << std::setw(12) << r.elapsed.count()
+          << std::setw(12) << r.wake_in.count() << r.path << '\n';
+    res.set_content(out.str(), "text/plain");
+  });
+}
+
+RequestDebugServer::~RequestDebugServer() { stop(); }
+
+int RequestDebugServer::start(const std::string &host, int port) {
+  if (impl_->thread.joinable())
+    return -1;
+  int bound = port == 0 ? impl_->server.bind_to_any_port(host)
+                        : (impl_->server.bind_to_port(host, port) ? port : -1);
+  if (bound < 0)
+    return -1;
+  impl_->thread = std::thread([this] { impl_->server.listen_after_bind(); });
+  return bound;
+}
+
+void RequestDebugServer::stop() {
+  if (!impl_->thread.joinable())
+    return;
+  impl_->server.stop();
+  impl_->thread.join();
+}
+
+} // namespace nexusmods
@@ -0,0 +1,207 @@
+#include "nexusmods/search_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+
+namespace nexusmods {
+
+namespace {
+
+constexpr float kNameWeight = 3.0f;
+constexpr float kAuthorWeight = 2.0f;
+constexpr float kSummaryWeight = 1.0f;
+
+// Lowercase ASCII letters and digits; everything else (punctuation, runs of
+// whitespace) collapses to a single space. Non-ASCII bytes are kept as-is.
+std::string normalize(std::string_view text) {
+  std::string out;
+  out.reserve(text.size() + 2);
+  out.push_back(' ');
+  for (unsigned char c : text) {
+    if (c >= 0x80 || std::isalnum(c))
+      out.push_back(static_cast<char>(std::tolower(c)));
+    else if (out.back() != ' ')
+      out.push_back(' ');
+  }
+  return out;
+}
+
+uint32_t pack(const char *p) {
+  return static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16 |
+         static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8 |
+         static_cast<uint32_t>(static_cast<unsigned char>(p[2]));
+}
+
+// Trigrams of normalized text. Words start with a space, so a short query
+// like "sk" still matches as a word prefix through " sk".
+template <typename F> void for_each_trigram(const std::string &norm, F &&f) {
+  for (size_t i = 0; i + 3 <= norm.size(); ++i)
+    if (!(norm[i + 1] == ' ' || norm[i + 2] == ' '))
+      f(pack(norm.data() + i));
+}
+
+} // namespace
+
+void SearchIndex::add(const Mod &mod) {
+  std::unordered_map<uint32_t, float> weights;
+  auto collect = [&](const std::string &text, float w) {
+    for_each_trigram(normalize(text), [&](uint32_t t) {
+      float &cur = weights[t];
+      cur = std::max(cur, w);
+    });
+  };
+  collect(mod.name, kNameWeight);
+  collect(mod.author, kAuthorWeight);
+  collect(mod.summary, kSummaryWeight);
+
+  std::unique_lock<std::shared_mutex> l(mutex_);
+  uint64_t k = key(mod.game_id, mod.mod_id);
+  remove_locked(k);
+
+  auto doc = static_cast<uint32_t>(docs_.size());
+  docs_.push_back({mod.game_id, mod.mod_id, true});
+  by_key_[k] = doc;
+  ++live_;
+  for (auto &[t, w] : weights)
+    postings_[t].push_back({doc, w});
+
+  maybe_compact_locked();
+}
+
+void SearchIndex::remove(int64_t game_id, int64_t mod_id) {
+  std::unique_lock<std::shared_mutex> l(mutex_);
+  remove_locked(key(game_id, mod_id));
+  maybe_compact_locked();
+}
+
+void SearchIndex::remove_locked(uint64_t k) {
+  auto it = by_key_.find(k);
+  if (it == by_key_.end())
+    return;
+  docs_[it->second].live = false;
+  by_key_.erase(it);
+  --live_;
+}
+
+void SearchIndex::maybe_compact_locked() {
+  size_t dead = docs_.size() - live_;
+  if (dead < 1024 || dead < live_)
+    return;
+
+  std::vector<uint32_t> remap(docs_.size(), UINT32_MAX);
+  std::vector<Doc> docs;
+  docs.reserve(live_);
+  for (uint32_t i = 0; i < docs_.size(); ++i) {
+    if (!docs_[i].live)
+      continue;
+    remap[i] = static_cast<uint32_t>(docs.size());
+    docs.push_back(docs_[i]);
+  }
+  for (auto it = postings_.begin(); it != postings_.end();) {
+    auto &list = it->second;
+    size_t out = 0;
+    for (auto &p : list)
+      if (remap[p.doc] != UINT32_MAX)
+        list[out++] = {remap[p.doc], p.weight};
+    list.resize(out);
+    if (list.empty())
+      it = postings_.erase(it);
+    else
+      ++it;
+  }
+  for (auto &[k, doc] : by_key_)
+    doc = remap[doc];
+  docs_ = std::move(docs);
+}
+
+std::vector<SearchIndex::Hit> SearchIndex::search(std::string_view query,
+                                                  size_t limit) const {
+  std::vector<uint32_t> trigrams;
+  std::string norm = normalize(query);
+  while (!norm.empty() && norm.back() == ' ')
+    norm.pop_back();
+  for_each_trigram(norm, [&](uint32_t t) { trigrams.push_back(t); });
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+  if (trigrams.empty() || limit == 0)
+    return {};
+
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  std::vector<const std::vector<Posting> *> lists;
+  lists.reserve(trigrams.size());
+  for (uint32_t t : trigrams) {
+    auto it = postings_.find(t);
+    if (it != postings_.end())
+      lists.push_back(&it->second);
+  }
+  std::sort(lists.begin(), lists.end(),
+            [](auto *a, auto *b) { return a->size() < b->size(); });
+
+  // A hit must contain at least half of the query's trigrams, so it appears
+  // in at least one of the rarest (total - need + 1) lists. Only those lists
+  // produce candidates; the common ones merely add to candidates' scores.
+  const size_t need = (trigrams.size() + 1) / 2;
+  if (lists.size() < need)
+    return {};
+  const size_t seeding = lists.size() - need + 1;
+
+  std::vector<float> scores(docs_.size(), 0.0f);
+  std::vector<uint16_t> matched(docs_.size(), 0);
+  std::vector<uint32_t> touched;
+  const float n = static_cast<float>(std::max<size_t>(live_, 1));
+  for (size_t i = 0; i < lists.size(); ++i) {
+    const auto &list = *lists[i];
+    float idf = std::log1p(n / static_cast<float>(list.size()));
+    auto credit = [&](const Posting &p) {
+      matched[p.doc]++;
+      scores[p.doc] += idf * p.weight;
+    };
+    if (i < seeding) {
+      for (const auto &p : list) {
+        if (!docs_[p.doc].live)
+          continue;
+        if (matched[p.doc] == 0)
+          touched.push_back(p.doc);
+        credit(p);
+      }
+    } else if (touched.size() * 16 < list.size()) {
+      // Postings are ordered by doc id, so look candidates up directly.
+      for (uint32_t d : touched) {
+        auto it = std::lower_bound(
+            list.begin(), list.end(), d,
+            [](const Posting &p, uint32_t doc) { return p.doc < doc; });
+        if (it != list.end() && it->doc == d)
+          credit(*it);
+      }
+    } else {
+      for (const auto &p : list)
+        if (matched[p.doc] > 0)
+          credit(p);
+    }
+  }
+
+  std::vector<Hit> hits;
+  hits.reserve(touched.size());
+  for (uint32_t d : touched)
+    if (matched[d] >= need)
+      hits.push_back({docs_[d].game_id, docs_[d].mod_id, scores[d]});
+
+  auto by_score = [](const Hit &a, const Hit &b) { return a.score > b.score; };
+  if (hits.size() > limit) {
+    std::partial_sort(hits.begin(), hits.begin() + limit, hits.end(),
+                      by_score);
+    hits.resize(limit);
+  } else {
+    std::sort(hits.begin(), hits.end(), by_score);
+  }
+  return hits;
+}
+
+size_t SearchIndex::size() const {
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  return live_;
+}
+
+} // namespace nexusmods
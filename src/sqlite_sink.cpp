@@ -0,0 +1,343 @@
+#include "nexusmods/sqlite_sink.h"
+
+#include <type_traits>
+
+#include <sqlite3.h>
+
+#include "rapidjson/document.h"
+#include "record_columns.h"
+
+namespace nexusmods {
+
+namespace {
+
+template <typename R> const char *sql_type(const RecordColumn<R> &c) {
+  return holds_field<std::string>(c) ? "TEXT" : "INTEGER";
+}
+
+template <typename R>
+int bind(sqlite3_stmt *s, int i, const RecordColumn<R> &c, const R &row) {
+  return visit_field(c, row, [&](const auto &v) {
+    using T = std::decay_t<decltype(v)>;
+    if constexpr (std::is_same_v<T, std::string>)
+      return sqlite3_bind_text(s, i, v.data(), static_cast<int>(v.size()),
+                               SQLITE_STATIC);
+    else if constexpr (std::is_same_v<T, bool>)
+      return sqlite3_bind_int(s, i, v ? 1 : 0);
+    else
+      return sqlite3_bind_int64(s, i, v);
+  });
+}
+
+// Categories are stored with their game id, which GameCategory lacks.
+struct CategoryRow {
+  int64_t game_id = 0;
+  int64_t category_id = 0;
+  int64_t parent_category = 0;
+  std::string name;
+};
+
+template <typename R> struct TableSpec {
+  const char *name;
+  RecordColumns<R> columns;
+  const char *key; // primary key column list
+};
+
+const TableSpec<Mod> &mods_table() {
+  static const TableSpec<Mod> t{
+      "mods",
+      {
+          column("game_id", &Mod::game_id),
+          column("mod_id", &Mod::mod_id),
+          column("domain_name", &Mod::domain_name),
+          column("name", &Mod::name),
+          column("summary", &Mod::summary),
+          column("version", &Mod::version),
+          column("author", &Mod::author),
+          column("uploaded_by", &Mod::uploaded_by),
+          column("picture_url", &Mod::picture_url),
+          column("status", &Mod::status),
+          column("category_id", &Mod::category_id),
+          column("downloads", &Mod::downloads),
+          column("unique_downloads", &Mod::unique_downloads),
+          column("endorsement_count", &Mod::endorsement_count),
+          column("created_timestamp", &Mod::created_timestamp),
+          column("updated_timestamp", &Mod::updated_timestamp),
+          column("contains_adult_content", &Mod::contains_adult_content),
+          column("available", &Mod::available),
+      },
+      "game_id, mod_id"};
+  return t;
+}
+
+const TableSpec<ModFile> &files_table() {
+  static const TableSpec<ModFile> t{
+      "files",
+      {
+          column("game_id", &ModFile::game_id),
+          column("file_id", &ModFile::file_id),
+          column("mod_id", &ModFile::mod_id),
+          column("name", &ModFile::name),
+          column("version", &ModFile::version),
+          column("mod_version", &ModFile::mod_version),
+          column("category_name", &ModFile::category_name),
+          column("file_name", &ModFile::file_name),
+          column("category_id", &ModFile::category_id),
+          column("size_in_bytes", &ModFile::size_in_bytes),
+          column("uploaded_timestamp", &ModFile::uploaded_timestamp),
+          column("is_primary", &ModFile::is_primary),
+      },
+      "game_id, file_id"};
+  return t;
+}
+
+const TableSpec<Game> &games_table() {
+  static const TableSpec<Game> t{"games",
+                                 {
+                                     column("id", &Game::id),
+                                     column("name", &Game::name),
+                                     column("domain_name", &Game::domain_name),
+                                     column("genre", &Game::genre),
+                                     column("mods", &Game::mods),
+                                     column("downloads", &Game::downloads),
+                                     column("file_count", &Game::file_count),
+                                 },
+                                 "id"};
+  return t;
+}
+
+const TableSpec<CategoryRow> &categories_table() {
+  static const TableSpec<CategoryRow> t{
+      "categories",
+      {
+          column("game_id", &CategoryRow::game_id),
+          column("category_id", &CategoryRow::category_id),
+          column("parent_category", &CategoryRow::parent_category),
+          column("name", &CategoryRow::name),
+      },
+      "game_id, category_id"};
+  return t;
+}
+
+bool is_key_column(const char *key, const std::string &column) {
+  return (", " + std::string(key) + ",").find(", " + column + ",") !=
+         std::string::npos;
+}
+
+template <typename R> std::string create_sql(const TableSpec<R> &t) {
+  std::string sql = std::string("CREATE TABLE IF NOT EXISTS ") + t.name + " (";
+  for (const auto &c : t.columns)
+    sql += c.name + " " + sql_type(c) + " NOT NULL, ";
+  return sql + "PRIMARY KEY (" + t.key + "))";
+}
+
+// INSERT ... ON CONFLICT DO UPDATE, so re-syncing a row updates it in place
+// instead of deleting and reinserting it like INSERT OR REPLACE would.
+template <typename R> std::string upsert_sql(const TableSpec<R> &t) {
+  std::string cols, params, updates;
+  for (const auto &c : t.columns) {
+    if (!cols.empty()) {
+      cols += ", ";
+      params += ", ";
+    }
+    cols += c.name;
+    params += "?";
+    if (!is_key_column(t.key, c.name)) {
+      if (!updates.empty())
+        updates += ", ";
+      updates += c.name + " = excluded." + c.name;
+    }
+  }
+  return std::string("INSERT INTO ") + t.name + " (" + cols + ") VALUES (" +
+         params + ") ON CONFLICT (" + t.key + ") DO UPDATE SET " + updates;
+}
+
+} // namespace
+
+struct SqliteSink::Impl {
+  Options options;
+  sqlite3 *db = nullptr;
+  sqlite3_stmt *mod_stmt = nullptr;
+  sqlite3_stmt *file_stmt = nullptr;
+  sqlite3_stmt *game_stmt = nullptr;
+  sqlite3_stmt *category_stmt = nullptr;
+  bool in_txn = false;
+  size_t pending = 0;
+  size_t written = 0;
+  std::string error;
+
+  bool is_open() const { return db != nullptr; }
+
+  bool fail(const char *what) {
+    error = std::string(what) + ": " + (db ? sqlite3_errmsg(db) : "no database");
+    return false;
+  }
+
+  bool exec(const char *sql) {
+    char *msg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &msg) != SQLITE_OK) {
+      error = std::string(sql) + ": " + (msg ? msg : "unknown error");
+      sqlite3_free(msg);
+      return false;
+    }
+    return true;
+  }
+
+  bool prepare(const std::string &sql, sqlite3_stmt **stmt) {
+    if (sqlite3_prepare_v3(db, sql.c_str(), static_cast<int>(sql.size()),
+                           SQLITE_PREPARE_PERSISTENT, stmt, nullptr) != SQLITE_OK)
+      return fail("prepare");
+    return true;
+  }
+
+  bool open(const std::string &path) {
+    if (sqlite3_open_v2(path.c_str(), &db,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE |
+                            SQLITE_OPEN_NOMUTEX,
+                        nullptr) != SQLITE_OK)
+      return fail("open");
+    if (options.wal && !exec("PRAGMA journal_mode = WAL"))
+      return false;
+    if (!exec("PRAGMA synchronous = NORMAL") ||
+        !exec("PRAGMA temp_store = MEMORY"))
+      return false;
+    for (const auto &sql :
+         {create_sql(mods_table()), create_sql(files_table()),
+          create_sql(games_table()), create_sql(categories_table())})
+      if (!exec(sql.c_str()))
+        return false;
+    return prepare(upsert_sql(mods_table()), &mod_stmt) &&
+           prepare(upsert_sql(files_table()), &file_stmt) &&
+           prepare(upsert_sql(games_table()), &game_stmt) &&
+           prepare(upsert_sql(categories_table()), &category_stmt);
+  }
+
+  template <typename R>
+  bool write(const TableSpec<R> &t, sqlite3_stmt *stmt, const R &row) {
+    if (!is_open()) {
+      error = "not open";
+      return false;
+    }
+    if (!in_txn) {
+      if (!exec("BEGIN"))
+        return false;
+      in_txn = true;
+    }
+    for (size_t i = 0; i < t.columns.size(); ++i)
+      if (bind(stmt, static_cast<int>(i + 1), t.columns[i], row) != SQLITE_OK)
+        return fail("bind");
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE)
+      return fail(t.name);
+    ++written;
+    if (++pending >= options.batch_rows)
+      return commit();
+    return true;
+  }
+
+  bool commit() {
+    if (!in_txn)
+      return true;
+    if (!exec("COMMIT"))
+      return false;
+    in_txn = false;
+    pending = 0;
+    return true;
+  }
+
+  bool close() {
+    bool ok = commit();
+    for (auto *s : {mod_stmt, file_stmt, game_stmt, category_stmt})
+      sqlite3_finalize(s);
+    mod_stmt = file_stmt = game_stmt = category_stmt = nullptr;
+    if (sqlite3_close(db) != SQLITE_OK)
+      ok = fail("close");
+    db = nullptr;
+    return ok;
+  }
+};
+
+SqliteSink::SqliteSink() : impl_(std::make_unique<Impl>()) {}
+
+SqliteSink::~SqliteSink() {
+  if (impl_->is_open())
+    close();
+}
+
+bool SqliteSink::open(const std::string &path) {
+  return open(path, Options());
+}
+
+bool SqliteSink::open(const std::string &path, Options options) {
+  if (impl_->is_open() && !close())
+    return false;
+  if (options.batch_rows == 0)
+    options.batch_rows = 1;
+  impl_->options = options;
+  impl_->pending = 0;
+  impl_->written = 0;
+  if (!impl_->open(path)) {
+    std::string error = impl_->error;
+    impl_->close();
+    impl_->error = std::move(error);
+    return false;
+  }
+  return true;
+}
+
+bool SqliteSink::upsert(const Mod &mod) {
+  return impl_->write(mods_table(), impl_->mod_stmt, mod);
+}
+
+bool SqliteSink::upsert(const ModFile &file) {
+  return impl_->write(files_table(), impl_->file_stmt, file);
+}
+
+bool SqliteSink::upsert(const Game &game) {
+  if (!impl_->write(games_table(), impl_->game_stmt, game))
+    return false;
+  for (const auto &c : game.categories) {
+    CategoryRow row{game.id, c.category_id, c.parent_category, c.name};
+    if (!impl_->write(categories_table(), impl_->category_stmt, row))
+      return false;
+  }
+  return true;
+}
+
+bool SqliteSink::apply(const ChangeRecord &change) {
+  rapidjson::Document doc;
+  doc.Parse(change.payload.data(), change.payload.size());
+  if (doc.HasParseError()) {
+    impl_->error = "change record payload is not JSON";
+    return false;
+  }
+  switch (change.kind) {
+  case ChangeRecord::Kind::ModUpdated:
+    if (auto mod = Mod::from_json(doc))
+      return upsert(*mod);
+    break;
+  case ChangeRecord::Kind::FileUpdated:
+    if (auto file = ModFile::from_json(doc, change.mod_id)) {
+      file->game_id = change.game_id;
+      return upsert(*file);
+    }
+    break;
+  }
+  impl_->error = "change record payload has the wrong shape";
+  return false;
+}
+
+bool SqliteSink::commit() { return impl_->commit(); }
+
+bool SqliteSink::close() {
+  if (!impl_->is_open())
+    return true;
+  return impl_->close();
+}
+
+size_t SqliteSink::rows_written() const { return impl_->written; }
+
+const std::string &SqliteSink::last_error() const { return impl_->error; }
+
+} // namespace nexusmods
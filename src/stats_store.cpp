@@ -0,0 +1,310 @@
+#include "nexusmods/stats_store.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace nexusmods {
+
+namespace {
+
+constexpr uint32_t kChunkSamples = 256;
+constexpr char kMagic[4] = {'N', 'X', 'T', 'S'};
+constexpr uint32_t kFormatVersion = 1;
+
+uint64_t zigzag(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+void put_bits(std::vector<uint64_t> &words, uint64_t &bits, uint64_t value,
+              unsigned n) {
+  if (n == 0)
+    return;
+  if (n < 64)
+    value &= (uint64_t(1) << n) - 1;
+  unsigned offset = bits % 64;
+  if (offset == 0)
+    words.push_back(0);
+  words.back() |= value << offset;
+  if (offset + n > 64) {
+    words.push_back(value >> (64 - offset));
+  }
+  bits += n;
+}
+
+class BitReader {
+public:
+  explicit BitReader(const std::vector<uint64_t> &words) : words_(words) {}
+
+  uint64_t get(unsigned n) {
+    if (n == 0)
+      return 0;
+    size_t word = pos_ / 64;
+    unsigned offset = pos_ % 64;
+    uint64_t v = words_[word] >> offset;
+    if (offset + n > 64)
+      v |= words_[word + 1] << (64 - offset);
+    pos_ += n;
+    return n < 64 ? v & ((uint64_t(1) << n) - 1) : v;
+  }
+
+private:
+  const std::vector<uint64_t> &words_;
+  uint64_t pos_ = 0;
+};
+
+// Delta-of-delta buckets, Gorilla style: a prefix of 1..4 bits selects how
+// many payload bits follow. Most polled counters land in the '0' bucket.
+void put_dod(std::vector<uint64_t> &words, uint64_t &bits, int64_t dod) {
+  uint64_t z = zigzag(dod);
+  if (z == 0) {
+    put_bits(words, bits, 0b0, 1);
+  } else if (z < (uint64_t(1) << 7)) {
+    put_bits(words, bits, 0b01, 2);
+    put_bits(words, bits, z, 7);
+  } else if (z < (uint64_t(1) << 12)) {
+    put_bits(words, bits, 0b011, 3);
+    put_bits(words, bits, z, 12);
+  } else if (z < (uint64_t(1) << 20)) {
+    put_bits(words, bits, 0b0111, 4);
+    put_bits(words, bits, z, 20);
+  } else {
+    put_bits(words, bits, 0b1111, 4);
+    put_bits(words, bits, z, 64);
+  }
+}
+
+int64_t get_dod(BitReader &r) {
+  // Prefix bits are written LSB first: 0, 10, 110, 1110, 1111.
+  if (r.get(1) == 0)
+    return 0;
+  if (r.get(1) == 0)
+    return unzigzag(r.get(7));
+  if (r.get(1) == 0)
+    return unzigzag(r.get(12));
+  if (r.get(1) == 0)
+    return unzigzag(r.get(20));
+  return unzigzag(r.get(64));
+}
+
+template <typename T> void write_raw(std::ofstream &out, const T &v) {
+  out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template <typename T> bool read_raw(std::ifstream &in, T &v) {
+  return static_cast<bool>(in.read(reinterpret_cast<char *>(&v), sizeof(v)));
+}
+
+} // namespace
+
+size_t StatsStore::KeyHash::operator()(const Key &k) const {
+  uint64_t h = static_cast<uint64_t>(k.game_id) * 0x9e3779b97f4a7c15ULL;
+  h ^= static_cast<uint64_t>(k.mod_id) + 0x632be59bd9b4e019ULL + (h << 6) +
+       (h >> 2);
+  return static_cast<size_t>(h ^ static_cast<uint64_t>(k.metric));
+}
+
+void StatsStore::encode(Series &s, int64_t timestamp, int64_t value) {
+  if (s.chunks.empty() || s.chunks.back().count == kChunkSamples) {
+    Chunk c;
+    c.first_ts = c.last_ts = timestamp;
+    c.count = 1;
+    put_bits(c.words, c.bits, static_cast<uint64_t>(value), 64);
+    s.chunks.push_back(std::move(c));
+    s.prev_ts = timestamp;
+    s.prev_value = value;
+    s.prev_ts_delta = s.prev_value_delta = 0;
+    return;
+  }
+
+  Chunk &c = s.chunks.back();
+  int64_t ts_delta = timestamp - s.prev_ts;
+  int64_t value_delta = value - s.prev_value;
+  put_dod(c.words, c.bits, ts_delta - s.prev_ts_delta);
+  put_dod(c.words, c.bits, value_delta - s.prev_value_delta);
+  s.prev_ts = timestamp;
+  s.prev_ts_delta = ts_delta;
+  s.prev_value = value;
+  s.prev_value_delta = value_delta;
+  c.last_ts = timestamp;
+  ++c.count;
+}
+
+template <typename F> void StatsStore::decode(const Chunk &c, F &&visit) {
+  BitReader r(c.words);
+  int64_t ts = c.first_ts;
+  int64_t value = static_cast<int64_t>(r.get(64));
+  int64_t ts_delta = 0, value_delta = 0;
+  if (!visit(Point{ts, value}))
+    return;
+  for (uint32_t i = 1; i < c.count; ++i) {
+    ts_delta += get_dod(r);
+    value_delta += get_dod(r);
+    ts += ts_delta;
+    value += value_delta;
+    if (!visit(Point{ts, value}))
+      return;
+  }
+}
+
+void StatsStore::record(const Mod &mod, std::optional<int64_t> timestamp) {
+  int64_t ts = timestamp ? *timestamp
+                         : std::chrono::duration_cast<std::chrono::seconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+  append(mod.game_id, mod.mod_id, Metric::Downloads, ts, mod.downloads);
+  append(mod.game_id, mod.mod_id, Metric::UniqueDownloads, ts,
+         mod.unique_downloads);
+  append(mod.game_id, mod.mod_id, Metric::Endorsements, ts,
+         mod.endorsement_count);
+}
+
+bool StatsStore::append(int64_t game_id, int64_t mod_id, Metric metric,
+                        int64_t timestamp, int64_t value) {
+  std::unique_lock<std::shared_mutex> l(mutex_);
+  Series &s = series_[Key{game_id, mod_id, metric}];
+  if (!s.chunks.empty() && timestamp < s.prev_ts)
+    return false;
+  encode(s, timestamp, value);
+  return true;
+}
+
+std::vector<StatsStore::Point> StatsStore::range(int64_t game_id,
+                                                 int64_t mod_id, Metric metric,
+                                                 int64_t from,
+                                                 int64_t to) const {
+  std::vector<Point> out;
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  auto it = series_.find(Key{game_id, mod_id, metric});
+  if (it == series_.end())
+    return out;
+  for (const auto &c : it->second.chunks) {
+    if (c.last_ts < from)
+      continue;
+    if (c.first_ts > to)
+      break;
+    decode(c, [&](const Point &p) {
+      if (p.timestamp > to)
+        return false;
+      if (p.timestamp >= from)
+        out.push_back(p);
+      return true;
+    });
+  }
+  return out;
+}
+
+std::optional<StatsStore::Point>
+StatsStore::latest(int64_t game_id, int64_t mod_id, Metric metric) const {
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  auto it = series_.find(Key{game_id, mod_id, metric});
+  if (it == series_.end() || it->second.chunks.empty())
+    return std::nullopt;
+  return Point{it->second.prev_ts, it->second.prev_value};
+}
+
+size_t StatsStore::series_count() const {
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  return series_.size();
+}
+
+size_t StatsStore::sample_count() const {
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  size_t n = 0;
+  for (const auto &[k, s] : series_)
+    for (const auto &c : s.chunks)
+      n += c.count;
+  return n;
+}
+
+size_t StatsStore::memory_bytes() const {
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  size_t n = 0;
+  for (const auto &[k, s] : series_)
+    for (const auto &c : s.chunks)
+      n += sizeof(Chunk) + c.words.capacity() * sizeof(uint64_t);
+  return n;
+}
+
+// Layout (host byte order): magic, version, series count, then per series
+// its key, encoder state and chunks with their raw bit streams.
+bool StatsStore::save(const std::string &path) const {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    return false;
+  std::shared_lock<std::shared_mutex> l(mutex_);
+  out.write(kMagic, sizeof(kMagic));
+  write_raw(out, kFormatVersion);
+  write_raw(out, static_cast<uint64_t>(series_.size()));
+  for (const auto &[k, s] : series_) {
+    write_raw(out, k.game_id);
+    write_raw(out, k.mod_id);
+    write_raw(out, static_cast<uint8_t>(k.metric));
+    write_raw(out, s.prev_ts);
+    write_raw(out, s.prev_ts_delta);
+    write_raw(out, s.prev_value);
+    write_raw(out, s.prev_value_delta);
+    write_raw(out, static_cast<uint64_t>(s.chunks.size()));
+    for (const auto &c : s.chunks) {
+      write_raw(out, c.first_ts);
+      write_raw(out, c.last_ts);
+      write_raw(out, c.count);
+      write_raw(out, c.bits);
+      write_raw(out, static_cast<uint64_t>(c.words.size()));
+      out.write(reinterpret_cast<const char *>(c.words.data()),
+                static_cast<std::streamsize>(c.words.size() * sizeof(uint64_t)));
+    }
+  }
+  return static_cast<bool>(out.flush());
+}
+
+bool StatsStore::load(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  uint32_t version = 0;
+  uint64_t count = 0;
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !read_raw(in, version) || version != kFormatVersion ||
+      !read_raw(in, count))
+    return false;
+
+  std::unordered_map<Key, Series, KeyHash> loaded;
+  for (uint64_t i = 0; i < count; ++i) {
+    Key k{};
+    uint8_t metric = 0;
+    Series s;
+    uint64_t chunks = 0;
+    if (!read_raw(in, k.game_id) || !read_raw(in, k.mod_id) ||
+        !read_raw(in, metric) || !read_raw(in, s.prev_ts) ||
+        !read_raw(in, s.prev_ts_delta) || !read_raw(in, s.prev_value) ||
+        !read_raw(in, s.prev_value_delta) || !read_raw(in, chunks))
+      return false;
+    k.metric = static_cast<Metric>(metric);
+    for (uint64_t j = 0; j < chunks; ++j) {
+      Chunk c;
+      uint64_t words = 0;
+      if (!read_raw(in, c.first_ts) || !read_raw(in, c.last_ts) ||
+          !read_raw(in, c.count) || !read_raw(in, c.bits) ||
+          !read_raw(in, words) || words != (c.bits + 63) / 64)
+        return false;
+      c.words.resize(words);
+      if (!in.read(reinterpret_cast<char *>(c.words.data()),
+                   static_cast<std::streamsize>(words * sizeof(uint64_t))))
+        return false;
+      s.chunks.push_back(std::move(c));
+    }
+    loaded.emplace(k, std::move(s));
+  }
+
+  std::unique_lock<std::shared_mutex> l(mutex_);
+  series_ = std::move(loaded);
+  return true;
+}
+
+} // namespace nexusmods
@@ -0,0 +1,93 @@
+#include "nexusmods/tls_context.h"
+
+#include <openssl/x509_vfy.h>
+
+#include "httplib.h"
+
+namespace nexusmods {
+
+std::shared_ptr<TlsContext> TlsContext::shared() {
+  static const std::shared_ptr<TlsContext> ctx(new TlsContext(std::string()));
+  return ctx;
+}
+
+std::shared_ptr<TlsContext>
+TlsContext::from_ca_file(const std::string &ca_file) {
+  return std::shared_ptr<TlsContext>(new TlsContext(ca_file));
+}
+
+TlsContext::TlsContext(const std::string &ca_file) {
+  SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+  if (!ctx)
+    return;
+  SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+  SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+  int loaded = ca_file.empty()
+                   ? SSL_CTX_set_default_verify_paths(ctx)
+                   : SSL_CTX_load_verify_locations(ctx, ca_file.c_str(),
+                                                   nullptr);
+  if (loaded != 1) {
+    SSL_CTX_free(ctx);
+    return;
+  }
+  // Sessions are kept here rather than in OpenSSL's internal cache so they
+  // can be looked up by server name when a new connection is made.
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT |
+                                          SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, &TlsContext::on_new_session);
+  SSL_CTX_set_app_data(ctx, this);
+  ctx_ = ctx;
+}
+
+TlsContext::~TlsContext() {
+  for (auto &[name, session] : sessions_)
+    SSL_SESSION_free(session);
+  if (ctx_)
+    SSL_CTX_free(ctx_);
+}
+
+X509_STORE *TlsContext::ca_store() const {
+  return ctx_ ? SSL_CTX_get_cert_store(ctx_) : nullptr;
+}
+
+void TlsContext::configure(httplib::SSLClient &client,
+                           const std::string &host) const {
+  if (!is_valid())
+    return;
+  // set_ca_cert_store takes ownership of the reference it is given.
+  X509_STORE_up_ref(ca_store());
+  client.set_ca_cert_store(ca_store());
+  // httplib's own verification would reload the default CA paths into the
+  // shared store for every client; let OpenSSL check chain and host name
+  // during the handshake instead.
+  client.enable_server_certificate_verification(false);
+  SSL_CTX *ctx = client.ssl_context();
+  SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+  X509_VERIFY_PARAM_set1_host(SSL_CTX_get0_param(ctx), host.c_str(), 0);
+}
+
+SSL_SESSION *TlsContext::take_session(const std::string &server_name) {
+  std::lock_guard<std::mutex> l(mutex_);
+  auto it = sessions_.find(server_name);
+  if (it == sessions_.end())
+    return nullptr;
+  SSL_SESSION *session = it->second;
+  sessions_.erase(it);
+  return session;
+}
+
+int TlsContext::on_new_session(SSL *ssl, SSL_SESSION *session) {
+  auto *self =
+      static_cast<TlsContext *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  const char *name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+  if (!self || !name)
+    return 0; // not kept; OpenSSL frees it
+  std::lock_guard<std::mutex> l(self->mutex_);
+  SSL_SESSION *&slot = self->sessions_[name];
+  if (slot)
+    SSL_SESSION_free(slot);
+  slot = session;
+  return 1; // we own the reference now
+}
+
+} // namespace nexusmods
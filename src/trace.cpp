@@ -0,0 +1,8 @@
+#include "trace.h"
+
+// Probe semaphores, raised by tracers while they are attached. The section
+// name is what systemtap's dtrace -G uses, and what bpftrace and perf expect.
+#define NEXUSMODS_DEFINE_SEMAPHORE(name)                                       \
+  volatile unsigned short nexusmods_##name##_semaphore                         \
+      __attribute__((section(".probes"))) = 0;
+NEXUSMODS_PROBES(NEXUSMODS_DEFINE_SEMAPHORE)
@@ -0,0 +1,73 @@
+#pragma once
+
+// USDT probes on the request path, provider "nexusmods". Built in with
+// -DNEXUSMODS_WITH_USDT=ON; each probe then has a semaphore that tracers
+// raise while attached, and costs a predicted-untaken branch until one does
+// (arguments are only evaluated while a tracer is attached), e.g.
+//
+//   bpftrace -e 'usdt:./app:nexusmods:backoff { @[str(arg0)] = sum(arg1); }'
+//
+// Without the option the macros expand to nothing (arguments included).
+//
+// Probes and their arguments:
+//   request_start  (const char *path)
+//   request_done   (const char *path, int status, int64_t elapsed_us)
+//                  status is -1 when every attempt failed
+//   retry          (const char *path, int attempt, int reason)
+//                  reason: 0 transport error, 1 HTTP 429, 2 daily limit,
+//                  3 hourly limit
+//   backoff        (const char *path, int seconds)
+//   stale_retry    (const char *path) reused connection resent on a new one
+//   parse_start    (const char *path, size_t bytes)
+//   parse_done     (const char *path, int ok)
+//   pool_hit       (size_t size_hint)
+//   pool_miss      (size_t size_hint)
+
+#ifdef NEXUSMODS_WITH_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define NEXUSMODS_PROBES(X)                                                    \
+  X(request_start)                                                             \
+  X(request_done)                                                              \
+  X(retry)                                                                     \
+  X(backoff)                                                                   \
+  X(stale_retry)                                                               \
+  X(parse_start)                                                               \
+  X(parse_done)                                                                \
+  X(pool_hit)                                                                  \
+  X(pool_miss)
+
+// Defined in trace.cpp, in the .probes section the tracers look for.
+#define NEXUSMODS_DECLARE_SEMAPHORE(name)                                      \
+  extern "C" volatile unsigned short nexusmods_##name##_semaphore;
+NEXUSMODS_PROBES(NEXUSMODS_DECLARE_SEMAPHORE)
+#undef NEXUSMODS_DECLARE_SEMAPHORE
+
+#define NEXUSMODS_TRACE_ENABLED(name)                                          \
+  __builtin_expect(nexusmods_##name##_semaphore != 0, 0)
+
+#define NEXUSMODS_TRACE1(name, a)                                              \
+  do {                                                                         \
+    if (NEXUSMODS_TRACE_ENABLED(name))                                         \
+      DTRACE_PROBE1(nexusmods, name, a);                                       \
+  } while (0)
+#define NEXUSMODS_TRACE2(name, a, b)                                           \
+  do {                                                                         \
+    if (NEXUSMODS_TRACE_ENABLED(name))                                         \
+      DTRACE_PROBE2(nexusmods, name, a, b);                                    \
+  } while (0)
+#define NEXUSMODS_TRACE3(name, a, b, c)                                        \
+  do {                                                                         \
+    if (NEXUSMODS_TRACE_ENABLED(name))                                         \
+      DTRACE_PROBE3(nexusmods, name, a, b, c);                                 \
+  } while (0)
+
+#else
+
+#define NEXUSMODS_TRACE1(name, a) ((void)0)
+#define NEXUSMODS_TRACE2(name, a, b) ((void)0)
+#define NEXUSMODS_TRACE3(name, a, b, c) ((void)0)
+
+#endif
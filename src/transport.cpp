@@ -0,0 +1,177 @@
+#include "nexusmods/transport.h"
+
+#include <unistd.h>
+
+#include "nexusmods/happy_eyeballs.h"
+#include "trace.h"
+
+namespace nexusmods {
+
+namespace {
+
+// How long a raced address stays pinned while it keeps working.
+constexpr auto kPinTtl = std::chrono::minutes(5);
+// After a race nobody won, httplib connects on its own for this long before
+// racing again; each failed race costs a full connect timeout.
+constexpr auto kRaceBackoff = std::chrono::seconds(30);
+
+bool is_connect_error(httplib::Error e) {
+  return e == httplib::Error::Connection ||
+         e == httplib::Error::ConnectionTimeout;
+}
+
+// Errors a connection the server closed while idle shows up as.
+bool is_stale_error(httplib::Error e) {
+  return e == httplib::Error::Read || e == httplib::Error::Write;
+}
+
+bool wants_close(const httplib::Response &r) {
+  auto it = r.headers.find("Connection");
+  return it != r.headers.end() && it->second == "close";
+}
+
+thread_local Transport::ConnectionHook *current_hook = nullptr;
+
+} // namespace
+
+Transport::ConnectionHook::ConnectionHook(std::function<void()> hook)
+    : hook_(std::move(hook)), outer_(current_hook) {
+  current_hook = this;
+}
+
+Transport::ConnectionHook::~ConnectionHook() { current_hook = outer_; }
+
+const std::function<void()> *Transport::connection_hook() {
+  return current_hook && current_hook->hook_ ? &current_hook->hook_ : nullptr;
+}
+
+HttplibTransport::HttplibTransport(const std::string &host, int port,
+                                   std::shared_ptr<TlsContext> tls)
+    : host_(host), port_(port), tls_(std::move(tls)), client_(host, port) {
+  client_.set_keep_alive(true);
+  if (tls_)
+    tls_->configure(client_, host);
+}
+
+httplib::Result HttplibTransport::get(const std::string &path,
+                                      const httplib::Params &params,
+                                      const httplib::Headers &headers,
+                                      httplib::ResponseHandler on_response,
+                                      httplib::ContentReceiver on_data) {
+  const uint64_t generation = cancel_generation_.load();
+  auto cancelled = [&] { return cancel_generation_.load() != generation; };
+  // httplib runs one request at a time per client anyway, so holding the
+  // lock across the request costs no concurrency. Callers queue here until
+  // the connection is theirs.
+  std::lock_guard<std::mutex> l(mutex_);
+  if (cancelled())
+    return httplib::Result(nullptr, httplib::Error::Canceled);
+  if (auto *hook = connection_hook())
+    (*hook)();
+  auto timeout = timeout_.load(std::memory_order_relaxed);
+  if (timeout != applied_timeout_) {
+    client_.set_connection_timeout(timeout);
+    client_.set_read_timeout(timeout);
+    client_.set_write_timeout(timeout);
+    applied_timeout_ = timeout;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (connection_open_ && now - last_used_ > max_idle_) {
+    client_.stop(); // likely closed by the server already
+    connection_open_ = false;
+  }
+  // An open connection is kept past the pin's TTL; re-pinning would only
+  // cost another handshake.
+  if (happy_eyeballs_ &&
+      (pinned_.empty() ? now - pinned_at_ > kRaceBackoff
+                       : !connection_open_ && now - pinned_at_ > kPinTtl))
+    pin_address_locked();
+  const bool reused = connection_open_;
+
+  bool answered = false;
+  httplib::ResponseHandler seen = [&](const httplib::Response &r) {
+    answered = true;
+    return !cancelled() && (!on_response || on_response(r));
+  };
+  const auto sent_at = std::chrono::steady_clock::now();
+  httplib::Result res = send_locked(path, params, headers, seen, on_data);
+  // A read cut short by cancel_all() looks just like a stale connection.
+  if (!res && cancelled()) {
+    connection_open_ = false;
+    return httplib::Result(nullptr, httplib::Error::Canceled);
+  }
+  // A read timeout is also Error::Read; only a failure that came before the
+  // timeout can be the server having closed the idle connection.
+  if (!res && reused && !answered && is_stale_error(res.error()) &&
+      std::chrono::steady_clock::now() - sent_at < applied_timeout_) {
+    NEXUSMODS_TRACE1(stale_retry, path.c_str());
+    client_.stop();
+    res = send_locked(path, params, headers, seen, on_data);
+  }
+
+  if (!res && is_connect_error(res.error()) && !pinned_.empty()) {
+    // The pinned address stopped answering: race again before the next
+    // attempt.
+    pinned_.clear();
+    pinned_at_ = {};
+  }
+  connection_open_ = res && !wants_close(*res);
+  last_used_ = std::chrono::steady_clock::now();
+  return res;
+}
+
+httplib::Result
+HttplibTransport::send_locked(const std::string &path,
+                              const httplib::Params &params,
+                              const httplib::Headers &headers,
+                              const httplib::ResponseHandler &on_response,
+                              const httplib::ContentReceiver &on_data) {
+  if (params.empty())
+    return client_.Get(path, headers, on_response, on_data);
+  return client_.Get(path, params, headers, on_response, on_data);
+}
+
+void HttplibTransport::set_timeout(std::chrono::seconds timeout) {
+  timeout_.store(timeout, std::memory_order_relaxed);
+}
+
+// Not under mutex_: get() holds it for the whole request. httplib's stop()
+// is thread-safe and shuts the socket of a request in progress; the
+// generation bump fails the callers queued behind it.
+void HttplibTransport::cancel_all() {
+  cancel_generation_.fetch_add(1);
+  client_.stop();
+}
+
+void HttplibTransport::set_max_idle(std::chrono::seconds max_idle) {
+  std::lock_guard<std::mutex> l(mutex_);
+  max_idle_ = max_idle;
+}
+
+void HttplibTransport::set_happy_eyeballs(bool enabled) {
+  std::lock_guard<std::mutex> l(mutex_);
+  happy_eyeballs_ = enabled;
+  if (!enabled) {
+    pinned_.clear();
+    pinned_at_ = {};
+    client_.set_hostname_addr_map({});
+  }
+}
+
+// The raced socket itself is dropped: httplib can't adopt a connected fd,
+// but it reconnects to the pinned address, which is known to answer. Host
+// header and SNI still use the host name.
+void HttplibTransport::pin_address_locked() {
+  pinned_at_ = std::chrono::steady_clock::now();
+  auto won = race_connect(host_, port_, applied_timeout_);
+  if (!won || won->address.empty()) {
+    pinned_.clear();
+    client_.set_hostname_addr_map({});
+    return;
+  }
+  ::close(won->fd);
+  pinned_ = won->address;
+  client_.set_hostname_addr_map({{host_, pinned_}});
+}
+
+} // namespace nexusmods
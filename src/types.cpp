@@ -0,0 +1,156 @@
+#include "nexusmods/types.h"
+
+namespace nexusmods {
+
+namespace {
+
+int64_t get_int(const rapidjson::Value &v, const char *key) {
+  auto it = v.FindMember(key);
+  if (it == v.MemberEnd())
+    return 0;
+  const auto &m = it->value;
+  if (m.IsInt64())
+    return m.GetInt64();
+  if (m.IsUint64())
+    return static_cast<int64_t>(m.GetUint64());
+  if (m.IsDouble())
+    return static_cast<int64_t>(m.GetDouble());
+  return 0;
+}
+
+std::string get_string(const rapidjson::Value &v, const char *key) {
+  auto it = v.FindMember(key);
+  if (it == v.MemberEnd() || !it->value.IsString())
+    return std::string();
+  return std::string(it->value.GetString(), it->value.GetStringLength());
+}
+
+bool get_bool(const rapidjson::Value &v, const char *key) {
+  auto it = v.FindMember(key);
+  return it != v.MemberEnd() && it->value.IsBool() && it->value.GetBool();
+}
+
+} // namespace
+
+std::optional<Mod> Mod::from_json(const rapidjson::Value &v) {
+  if (!v.IsObject() || !v.HasMember("mod_id"))
+    return std::nullopt;
+  Mod m;
+  m.mod_id = get_int(v, "mod_id");
+  m.game_id = get_int(v, "game_id");
+  m.domain_name = get_string(v, "domain_name");
+  m.name = get_string(v, "name");
+  m.summary = get_string(v, "summary");
+  m.version = get_string(v, "version");
+  m.author = get_string(v, "author");
+  m.uploaded_by = get_string(v, "uploaded_by");
+  m.picture_url = get_string(v, "picture_url");
+  m.status = get_string(v, "status");
+  m.category_id = get_int(v, "category_id");
+  m.downloads = get_int(v, "mod_downloads");
+  m.unique_downloads = get_int(v, "mod_unique_downloads");
+  m.endorsement_count = get_int(v, "endorsement_count");
+  m.created_timestamp = get_int(v, "created_timestamp");
+  m.updated_timestamp = get_int(v, "updated_timestamp");
+  m.contains_adult_content = get_bool(v, "contains_adult_content");
+  m.available = get_bool(v, "available");
+  return m;
+}
+
+const FieldProjection &Mod::projection() {
+  static const FieldProjection p{
+      "mod_id",        "game_id",     "domain_name",  "name",
+      "summary",       "version",     "author",       "uploaded_by",
+      "picture_url",   "status",      "category_id",  "mod_downloads",
+      "mod_unique_downloads",         "endorsement_count",
+      "created_timestamp",            "updated_timestamp",
+      "contains_adult_content",       "available"};
+  return p;
+}
+
+std::optional<ModFile> ModFile::from_json(const rapidjson::Value &v,
+                                          int64_t mod_id) {
+  if (!v.IsObject() || !v.HasMember("file_id"))
+    return std::nullopt;
+  ModFile f;
+  f.file_id = get_int(v, "file_id");
+  f.mod_id = mod_id;
+  f.name = get_string(v, "name");
+  f.version = get_string(v, "version");
+  f.mod_version = get_string(v, "mod_version");
+  f.category_name = get_string(v, "category_name");
+  f.file_name = get_string(v, "file_name");
+  f.category_id = get_int(v, "category_id");
+  f.size_in_bytes = get_int(v, "size_in_bytes");
+  if (f.size_in_bytes == 0)
+    f.size_in_bytes = get_int(v, "size_kb") * 1024;
+  f.uploaded_timestamp = get_int(v, "uploaded_timestamp");
+  f.is_primary = get_bool(v, "is_primary");
+  return f;
+}
+
+std::vector<ModFile> ModFile::list_from_json(const rapidjson::Value &doc,
+                                             int64_t mod_id) {
+  std::vector<ModFile> out;
+  if (!doc.IsObject())
+    return out;
+  auto files = doc.FindMember("files");
+  if (files == doc.MemberEnd() || !files->value.IsArray())
+    return out;
+  out.reserve(files->value.Size());
+  for (const auto &f : files->value.GetArray())
+    if (auto file = from_json(f, mod_id))
+      out.push_back(std::move(*file));
+  return out;
+}
+
+const FieldProjection &ModFile::projection() {
+  static const FieldProjection p{
+      "files.file_id",       "files.name",          "files.version",
+      "files.mod_version",   "files.category_name", "files.file_name",
+      "files.category_id",   "files.size_in_bytes", "files.size_kb",
+      "files.is_primary",    "files.uploaded_timestamp"};
+  return p;
+}
+
+std::optional<Game> Game::from_json(const rapidjson::Value &v) {
+  if (!v.IsObject() || !v.HasMember("domain_name"))
+    return std::nullopt;
+  Game g;
+  g.id = get_int(v, "id");
+  g.name = get_string(v, "name");
+  g.domain_name = get_string(v, "domain_name");
+  g.genre = get_string(v, "genre");
+  g.mods = get_int(v, "mods");
+  g.downloads = get_int(v, "downloads");
+  g.file_count = get_int(v, "file_count");
+
+  auto cats = v.FindMember("categories");
+  if (cats != v.MemberEnd() && cats->value.IsArray()) {
+    g.categories.reserve(cats->value.Size());
+    for (const auto &c : cats->value.GetArray()) {
+      if (!c.IsObject())
+        continue;
+      GameCategory cat;
+      cat.category_id = get_int(c, "category_id");
+      // parent_category is `false` for top-level categories
+      cat.parent_category = get_int(c, "parent_category");
+      cat.name = get_string(c, "name");
+      g.categories.push_back(std::move(cat));
+    }
+  }
+  return g;
+}
+
+std::vector<Game> Game::list_from_json(const rapidjson::Value &doc) {
+  std::vector<Game> out;
+  if (!doc.IsArray())
+    return out;
+  out.reserve(doc.Size());
+  for (const auto &g : doc.GetArray())
+    if (auto game = from_json(g))
+      out.push_back(std::move(*game));
+  return out;
+}
+
+} // namespace nexusmods
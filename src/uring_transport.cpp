@@ -0,0 +1,988 @@
+#include "nexusmods/uring_transport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <liburing.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509_vfy.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace nexusmods {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kRecvBuffer = 16 * 1024;
+constexpr size_t kMaxHead = 64 * 1024;
+constexpr long long kTickNanos = 100 * 1000 * 1000;
+// A connect still pending after this moves on to the next address; the
+// last address gets whatever is left of the request timeout.
+constexpr auto kAddressTimeout = std::chrono::seconds(3);
+// Resolved addresses are looked up again after this, to follow DNS changes.
+constexpr auto kResolveTtl = std::chrono::minutes(5);
+
+// The low bits of a submission's user_data say what completed; the rest is
+// the Conn it belongs to (zero for loop-level events).
+enum Tag : uint64_t {
+  kConnect = 1,
+  kSend = 2,
+  kRecv = 3,
+  kWake = 4,
+  kTimer = 5,
+  kIgnore = 6, // cancellations
+};
+constexpr uint64_t kTagMask = 7;
+
+std::string url_encode(const std::string &s) {
+  static const char *hex = "0123456789ABCDEF";
+  std::string out;
+  out.reserve(s.size());
+  for (unsigned char c : s) {
+    if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      out.push_back(static_cast<char>(c));
+    } else {
+      out.push_back('%');
+      out.push_back(hex[c >> 4]);
+      out.push_back(hex[c & 15]);
+    }
+  }
+  return out;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return std::tolower(static_cast<unsigned char>(x)) ==
+                  std::tolower(static_cast<unsigned char>(y));
+         });
+}
+
+bool icontains(std::string_view haystack, std::string_view needle) {
+  if (needle.size() > haystack.size())
+    return false;
+  for (size_t i = 0; i + needle.size() <= haystack.size(); ++i)
+    if (iequals(haystack.substr(i, needle.size()), needle))
+      return true;
+  return false;
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+    s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+    s.remove_suffix(1);
+  return s;
+}
+
+// Incremental HTTP/1.1 response parser: status line and headers, then a
+// Content-Length, chunked or read-until-close body streamed to `on_data`.
+class ResponseParser {
+public:
+  enum class Status { More, Done, Invalid, Canceled };
+
+  ResponseParser(const httplib::ResponseHandler &on_response,
+                 const httplib::ContentReceiver &on_data)
+      : on_response_(on_response), on_data_(on_data),
+        res_(std::make_unique<httplib::Response>()) {}
+
+  Status feed(const char *p, size_t n) {
+    started_ = true;
+    for (;;) {
+      switch (phase_) {
+      case Phase::Head: {
+        size_t from = buf_.size() >= 3 ? buf_.size() - 3 : 0;
+        buf_.append(p, n);
+        n = 0;
+        size_t end = buf_.find("\r\n\r\n", from);
+        if (end == std::string::npos)
+          return buf_.size() > kMaxHead ? Status::Invalid : Status::More;
+        rest_ = buf_.substr(end + 4);
+        buf_.resize(end);
+        if (!parse_head(buf_))
+          return Status::Invalid;
+        buf_.clear();
+        if (on_response_ && !on_response_(*res_))
+          return Status::Canceled;
+        if (phase_ == Phase::Body && remaining_ == 0)
+          return Status::Done;
+        p = rest_.data();
+        n = rest_.size();
+        continue;
+      }
+      case Phase::Body: {
+        size_t k = static_cast<size_t>(std::min<uint64_t>(n, remaining_));
+        if (k > 0 && !deliver(p, k))
+          return Status::Canceled;
+        remaining_ -= k;
+        return remaining_ == 0 ? Status::Done : Status::More;
+      }
+      case Phase::UntilClose:
+        if (n > 0 && !deliver(p, n))
+          return Status::Canceled;
+        return Status::More;
+      case Phase::ChunkData: {
+        size_t k = static_cast<size_t>(std::min<uint64_t>(n, remaining_));
+        if (k > 0 && !deliver(p, k))
+          return Status::Canceled;
+        p += k;
+        n -= k;
+        remaining_ -= k;
+        if (remaining_ == 0)
+          phase_ = Phase::ChunkEnd;
+        if (n == 0)
+          return Status::More;
+        continue;
+      }
+      case Phase::ChunkSize:
+      case Phase::ChunkEnd:
+      case Phase::Trailer: {
+        if (!take_line(p, n))
+          return buf_.size() > kMaxHead ? Status::Invalid : Status::More;
+        std::string line = std::move(buf_);
+        buf_.clear();
+        if (phase_ == Phase::ChunkSize) {
+          char *end = nullptr;
+          unsigned long long size = std::strtoull(line.c_str(), &end, 16);
+          if (end == line.c_str())
+            return Status::Invalid;
+          remaining_ = size;
+          phase_ = size == 0 ? Phase::Trailer : Phase::ChunkData;
+        } else if (phase_ == Phase::ChunkEnd) {
+          if (!line.empty())
+            return Status::Invalid;
+          phase_ = Phase::ChunkSize;
+        } else if (line.empty()) {
+          return Status::Done; // end of trailers
+        }
+        continue;
+      }
+      }
+    }
+  }
+
+  // The peer closed the connection.
+  Status eof() const {
+    return phase_ == Phase::UntilClose ? Status::Done : Status::Invalid;
+  }
+
+  bool started() const { return started_; }
+  bool keep_alive() const { return keep_alive_; }
+  std::unique_ptr<httplib::Response> take() { return std::move(res_); }
+
+private:
+  enum class Phase { Head, Body, UntilClose, ChunkSize, ChunkData, ChunkEnd,
+                     Trailer };
+
+  bool deliver(const char *p, size_t n) { return !on_data_ || on_data_(p, n); }
+
+  // Appends up to the next '\n' to buf_; true once a full line (without its
+  // CRLF) is there.
+  bool take_line(const char *&p, size_t &n) {
+    const char *nl = static_cast<const char *>(std::memchr(p, '\n', n));
+    if (!nl) {
+      buf_.append(p, n);
+      p += n;
+      n = 0;
+      return false;
+    }
+    buf_.append(p, nl);
+    n -= static_cast<size_t>(nl + 1 - p);
+    p = nl + 1;
+    if (!buf_.empty() && buf_.back() == '\r')
+      buf_.pop_back();
+    return true;
+  }
+
+  bool parse_head(std::string_view head) {
+    size_t eol = head.find("\r\n");
+    std::string_view status_line = head.substr(0, eol);
+    if (status_line.size() < 12 || status_line.substr(0, 5) != "HTTP/")
+      return false;
+    res_->status = std::atoi(std::string(status_line.substr(9, 3)).c_str());
+    if (res_->status < 100)
+      return false;
+    keep_alive_ = status_line.substr(5, 3) != "1.0";
+
+    bool chunked = false;
+    std::optional<uint64_t> length;
+    while (eol != std::string_view::npos) {
+      head.remove_prefix(eol + 2);
+      eol = head.find("\r\n");
+      std::string_view line = head.substr(0, eol);
+      size_t colon = line.find(':');
+      if (colon == std::string_view::npos)
+        continue;
+      std::string_view name = trim(line.substr(0, colon));
+      std::string_view value = trim(line.substr(colon + 1));
+      res_->headers.emplace(std::string(name), std::string(value));
+      if (iequals(name, "Transfer-Encoding") && icontains(value, "chunked"))
+        chunked = true;
+      else if (iequals(name, "Content-Length"))
+        length = std::strtoull(std::string(value).c_str(), nullptr, 10);
+      else if (iequals(name, "Connection"))
+        keep_alive_ = icontains(value, "keep-alive") ||
+                      (keep_alive_ && !icontains(value, "close"));
+    }
+
+    if (res_->status == 204 || res_->status == 304 || res_->status < 200) {
+      phase_ = Phase::Body;
+      remaining_ = 0;
+    } else if (chunked) {
+      phase_ = Phase::ChunkSize;
+    } else if (length) {
+      phase_ = Phase::Body;
+      remaining_ = *length;
+    } else {
+      phase_ = Phase::UntilClose;
+      keep_alive_ = false;
+    }
+    return true;
+  }
+
+  const httplib::ResponseHandler &on_response_;
+  const httplib::ContentReceiver &on_data_;
+  std::unique_ptr<httplib::Response> res_;
+  Phase phase_ = Phase::Head;
+  std::string buf_;  // partial head or line
+  std::string rest_; // body bytes that arrived with the head
+  uint64_t remaining_ = 0;
+  bool keep_alive_ = true;
+  bool started_ = false;
+};
+
+struct Op {
+  Op(httplib::ResponseHandler r, httplib::ContentReceiver d)
+      : on_response(std::move(r)), on_data(std::move(d)),
+        parser(on_response, on_data) {}
+
+  std::string request;
+  httplib::ResponseHandler on_response;
+  httplib::ContentReceiver on_data;
+  ResponseParser parser;
+  std::function<void()> on_connection; // the caller's ConnectionHook
+  std::promise<httplib::Result> done;
+  Clock::time_point deadline;
+  bool retried = false;
+  size_t addr_index = 0; // into Impl::addrs, modulo its size
+  size_t addr_tries = 0; // addresses tried for the current connection
+};
+
+struct Conn {
+  enum class State { Connecting, Handshaking, Ready };
+
+  int fd = -1;
+  SSL *ssl = nullptr;
+  BIO *rbio = nullptr; // ciphertext from the socket, owned by ssl
+  BIO *wbio = nullptr; // ciphertext for the socket, owned by ssl
+  State state = State::Connecting;
+  Op *op = nullptr;
+  bool reused = false; // served a request before the current one
+  bool closing = false;
+  bool connect_pending = false, send_pending = false, recv_pending = false;
+  sockaddr_storage addr{};
+  socklen_t addrlen = 0;
+  size_t addr_index = 0;
+  Clock::time_point connect_deadline; // for this address
+  std::string out;     // ciphertext not yet submitted
+  std::string sending; // ciphertext owned by the in-flight send
+  char in[kRecvBuffer];
+
+  bool busy() const { return connect_pending || send_pending || recv_pending; }
+};
+
+} // namespace
+
+struct UringTransport::Impl {
+  std::string host;
+  std::string host_header;
+  int port;
+  Options options;
+  std::atomic<int64_t> timeout_seconds{30};
+
+  io_uring ring{};
+  bool ring_ok = false;
+  std::shared_ptr<TlsContext> tls;
+  SSL_CTX *ctx = nullptr; // borrowed from tls
+  int wake_fd = -1;
+  uint64_t wake_buf = 0;
+  __kernel_timespec tick{0, kTickNanos};
+  std::thread loop;
+
+  std::mutex mutex; // guards the members below
+  std::deque<Op *> incoming;
+  bool stop = false;
+  bool cancel = false; // cancel_all() requested
+  std::vector<std::pair<sockaddr_storage, socklen_t>> addrs;
+  Clock::time_point resolved_at; // zero: look up again on the next request
+
+  // Loop thread only.
+  std::unordered_set<Conn *> live;
+  std::unordered_set<Conn *> closing;
+  std::vector<Conn *> idle;
+  std::deque<Op *> waiting;
+  size_t preferred_addr = 0; // last address a connect succeeded on
+  bool wake_armed = false, timer_armed = false;
+
+  bool valid() const { return ring_ok && ctx && wake_fd >= 0; }
+
+  // Runs on the caller's thread, so a slow lookup never stalls the loop. A
+  // failed lookup keeps the previous addresses.
+  bool resolve() {
+    auto now = Clock::now();
+    {
+      std::lock_guard<std::mutex> l(mutex);
+      if (!addrs.empty() && now - resolved_at < kResolveTtl)
+        return true;
+    }
+    std::vector<std::pair<sockaddr_storage, socklen_t>> found;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) ==
+        0) {
+      for (auto *ai = res; ai; ai = ai->ai_next) {
+        sockaddr_storage ss{};
+        std::memcpy(&ss, ai->ai_addr, ai->ai_addrlen);
+        found.emplace_back(ss, static_cast<socklen_t>(ai->ai_addrlen));
+      }
+      freeaddrinfo(res);
+    }
+    std::lock_guard<std::mutex> l(mutex);
+    resolved_at = now;
+    if (!found.empty())
+      addrs = std::move(found);
+    return !addrs.empty();
+  }
+
+  size_t address_count() {
+    std::lock_guard<std::mutex> l(mutex);
+    return addrs.size();
+  }
+
+  // Every address failed; maybe DNS has moved on.
+  void resolve_again() {
+    std::lock_guard<std::mutex> l(mutex);
+    resolved_at = Clock::time_point();
+  }
+
+  // Null if the submission queue is still full after submitting it, e.g.
+  // while the kernel holds back submissions until completions are reaped.
+  io_uring_sqe *sqe() {
+    io_uring_sqe *s = io_uring_get_sqe(&ring);
+    if (!s) {
+      io_uring_submit(&ring);
+      s = io_uring_get_sqe(&ring);
+    }
+    return s;
+  }
+
+  static uint64_t tag(Conn *c, Tag t) {
+    return reinterpret_cast<uint64_t>(c) | t;
+  }
+
+  // Both are retried at the top of every loop turn until they get a slot.
+  void arm_wake() {
+    auto *s = sqe();
+    if (!s)
+      return;
+    io_uring_prep_read(s, wake_fd, &wake_buf, sizeof(wake_buf), 0);
+    io_uring_sqe_set_data64(s, kWake);
+    wake_armed = true;
+  }
+
+  void arm_timer() {
+    auto *s = sqe();
+    if (!s)
+      return;
+    io_uring_prep_timeout(s, &tick, 0, 0);
+    io_uring_sqe_set_data64(s, kTimer);
+    timer_armed = true;
+  }
+
+  void run() {
+    bool stopping = false;
+    while (!stopping) {
+      if (!wake_armed)
+        arm_wake();
+      if (!timer_armed)
+        arm_timer();
+      io_uring_submit_and_wait(&ring, 1);
+      io_uring_cqe *cqe = nullptr;
+      while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+        uint64_t data = io_uring_cqe_get_data64(cqe);
+        int res = cqe->res;
+        io_uring_cqe_seen(&ring, cqe);
+        if (data == kWake)
+          stopping = on_wake() || stopping;
+        else if (data == kTimer)
+          on_timer();
+        else if (data != kIgnore)
+          on_conn_event(reinterpret_cast<Conn *>(data & ~kTagMask),
+                        static_cast<Tag>(data & kTagMask), res);
+      }
+    }
+
+    cancel_in_flight();
+    for (Conn *c : std::vector<Conn *>(live.begin(), live.end()))
+      fail(c, httplib::Error::Canceled); // idle ones
+  }
+
+  // Waiting ops first, so failing connections doesn't dispatch them.
+  void cancel_in_flight() {
+    for (Op *op : waiting)
+      complete(op, nullptr, httplib::Error::Canceled);
+    waiting.clear();
+    for (Conn *c : std::vector<Conn *>(live.begin(), live.end()))
+      if (c->op)
+        fail(c, httplib::Error::Canceled);
+  }
+
+  // Returns true once the transport is shutting down.
+  bool on_wake() {
+    wake_armed = false;
+    std::deque<Op *> ops;
+    bool stopping;
+    bool cancelling;
+    {
+      std::lock_guard<std::mutex> l(mutex);
+      ops.swap(incoming);
+      stopping = stop;
+      cancelling = cancel;
+      cancel = false;
+    }
+    if (cancelling)
+      cancel_in_flight();
+    for (Op *op : ops) {
+      if (stopping || cancelling)
+        complete(op, nullptr, httplib::Error::Canceled);
+      else {
+        touch(op);
+        dispatch(op);
+      }
+    }
+    return stopping;
+  }
+
+  void on_timer() {
+    timer_armed = false;
+    auto now = Clock::now();
+    for (Conn *c : std::vector<Conn *>(live.begin(), live.end())) {
+      if (!c->op)
+        continue;
+      if (now >= c->op->deadline)
+        fail(c, c->state == Conn::State::Ready
+                    ? httplib::Error::Read
+                    : httplib::Error::ConnectionTimeout);
+      else if (c->state == Conn::State::Connecting &&
+               now >= c->connect_deadline)
+        next_address(c);
+    }
+    // Requests still waiting for a connection time out as well.
+    while (!waiting.empty() && now >= waiting.front()->deadline) {
+      Op *op = waiting.front();
+      waiting.pop_front();
+      complete(op, nullptr, httplib::Error::ConnectionTimeout);
+    }
+  }
+
+  void touch(Op *op) {
+    op->deadline = Clock::now() + std::chrono::seconds(timeout_seconds.load());
+  }
+
+  // Time spent in `waiting` counts against the request's timeout.
+  void dispatch(Op *op) {
+    bool free = !idle.empty() || live.size() < options.max_connections;
+    if (!free) {
+      waiting.push_back(op);
+      return;
+    }
+    if (op->on_connection)
+      op->on_connection();
+    if (!idle.empty()) {
+      Conn *c = idle.back();
+      idle.pop_back();
+      c->reused = true;
+      start_request(c, op);
+    } else {
+      connect(op);
+    }
+  }
+
+  void drain_waiting() {
+    while (!waiting.empty() &&
+           (!idle.empty() || live.size() < options.max_connections)) {
+      Op *op = waiting.front();
+      waiting.pop_front();
+      dispatch(op);
+    }
+  }
+
+  // New connection for `op`, starting from the address that last worked.
+  void connect(Op *op) {
+    op->addr_index = preferred_addr;
+    op->addr_tries = 0;
+    open_conn(op);
+  }
+
+  void open_conn(Op *op) {
+    std::pair<sockaddr_storage, socklen_t> addr{};
+    {
+      std::lock_guard<std::mutex> l(mutex);
+      if (!addrs.empty())
+        addr = addrs[op->addr_index % addrs.size()];
+    }
+    int fd = addr.second
+                 ? ::socket(addr.first.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0)
+                 : -1;
+    auto *s = fd >= 0 ? sqe() : nullptr;
+    if (!s) {
+      if (fd >= 0)
+        ::close(fd);
+      complete(op, nullptr, httplib::Error::Connection);
+      return;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    auto *c = new Conn;
+    c->fd = fd;
+    c->op = op;
+    c->addr = addr.first;
+    c->addrlen = addr.second;
+    c->addr_index = op->addr_index;
+    c->connect_deadline = Clock::now() + kAddressTimeout;
+    live.insert(c);
+    io_uring_prep_connect(s, fd, reinterpret_cast<sockaddr *>(&c->addr),
+                          c->addrlen);
+    io_uring_sqe_set_data64(s, tag(c, kConnect));
+    c->connect_pending = true;
+  }
+
+  // Move the request on a connection that couldn't connect to the next
+  // address. False if every address has been tried.
+  bool next_address(Conn *c) {
+    Op *op = c->op;
+    if (!op || op->addr_tries + 1 >= address_count())
+      return false;
+    ++op->addr_tries;
+    ++op->addr_index;
+    c->op = nullptr;
+    close_conn(c);
+    open_conn(op);
+    return true;
+  }
+
+  void on_conn_event(Conn *c, Tag t, int res) {
+    if (t == kConnect)
+      c->connect_pending = false;
+    else if (t == kSend)
+      c->send_pending = false;
+    else if (t == kRecv)
+      c->recv_pending = false;
+
+    if (c->closing) {
+      if (!c->busy()) {
+        closing.erase(c);
+        destroy(c);
+      }
+      return;
+    }
+
+    switch (t) {
+    case kConnect:
+      on_connect(c, res);
+      break;
+    case kSend:
+      on_send(c, res);
+      break;
+    case kRecv:
+      on_recv(c, res);
+      break;
+    default:
+      break;
+    }
+  }
+
+  void on_connect(Conn *c, int res) {
+    if (res < 0) {
+      if (!next_address(c)) {
+        resolve_again();
+        fail(c, httplib::Error::Connection);
+      }
+      return;
+    }
+    preferred_addr = c->addr_index;
+    c->ssl = SSL_new(ctx);
+    c->rbio = BIO_new(BIO_s_mem());
+    c->wbio = BIO_new(BIO_s_mem());
+    if (!c->ssl || !c->rbio || !c->wbio) {
+      BIO_free(c->rbio);
+      BIO_free(c->wbio);
+      c->rbio = c->wbio = nullptr;
+      fail(c, httplib::Error::SSLConnection);
+      return;
+    }
+    SSL_set_bio(c->ssl, c->rbio, c->wbio);
+    SSL_set_tlsext_host_name(c->ssl, host.c_str());
+    SSL_set1_host(c->ssl, host.c_str());
+    if (SSL_SESSION *session = tls->take_session(host)) {
+      SSL_set_session(c->ssl, session);
+      SSL_SESSION_free(session);
+    }
+    SSL_set_connect_state(c->ssl);
+    c->state = Conn::State::Handshaking;
+    handshake(c);
+  }
+
+  void handshake(Conn *c) {
+    int r = SSL_do_handshake(c->ssl);
+    if (!flush(c)) {
+      fail(c, httplib::Error::SSLConnection);
+      return;
+    }
+    if (r == 1) {
+      c->state = Conn::State::Ready;
+      send_request(c);
+      return;
+    }
+    int err = SSL_get_error(c->ssl, r);
+    if (err == SSL_ERROR_WANT_READ) {
+      if (!arm_recv(c))
+        fail(c, httplib::Error::SSLConnection);
+      return;
+    }
+    ERR_clear_error();
+    fail(c, SSL_get_verify_result(c->ssl) != X509_V_OK
+                ? httplib::Error::SSLServerVerification
+                : httplib::Error::SSLConnection);
+  }
+
+  void start_request(Conn *c, Op *op) {
+    c->op = op;
+    if (c->state == Conn::State::Ready)
+      send_request(c);
+  }
+
+  void send_request(Conn *c) {
+    if (!c->op)
+      return;
+    const std::string &req = c->op->request;
+    if (SSL_write(c->ssl, req.data(), static_cast<int>(req.size())) <= 0) {
+      ERR_clear_error();
+      fail(c, httplib::Error::Write);
+      return;
+    }
+    if (!flush(c) || !arm_recv(c))
+      fail(c, httplib::Error::Write);
+  }
+
+  // Move ciphertext OpenSSL produced into the send queue. False if it
+  // couldn't be submitted; the caller fails the connection.
+  bool flush(Conn *c) {
+    char buf[kRecvBuffer];
+    int n;
+    while ((n = BIO_read(c->wbio, buf, sizeof(buf))) > 0)
+      c->out.append(buf, static_cast<size_t>(n));
+    return submit_send(c);
+  }
+
+  bool submit_send(Conn *c) {
+    if (c->send_pending)
+      return true;
+    if (c->sending.empty())
+      c->sending.swap(c->out);
+    if (c->sending.empty())
+      return true;
+    auto *s = sqe();
+    if (!s)
+      return false;
+    io_uring_prep_send(s, c->fd, c->sending.data(), c->sending.size(),
+                       MSG_NOSIGNAL);
+    io_uring_sqe_set_data64(s, tag(c, kSend));
+    c->send_pending = true;
+    return true;
+  }
+
+  void on_send(Conn *c, int res) {
+    if (res <= 0) {
+      fail(c, httplib::Error::Write);
+      return;
+    }
+    c->sending.erase(0, static_cast<size_t>(res));
+    if (!submit_send(c))
+      fail(c, httplib::Error::Write);
+  }
+
+  bool arm_recv(Conn *c) {
+    if (c->recv_pending)
+      return true;
+    auto *s = sqe();
+    if (!s)
+      return false;
+    io_uring_prep_recv(s, c->fd, c->in, sizeof(c->in), 0);
+    io_uring_sqe_set_data64(s, tag(c, kRecv));
+    c->recv_pending = true;
+    return true;
+  }
+
+  void on_recv(Conn *c, int res) {
+    Op *op = c->op;
+    if (res <= 0) {
+      if (!op) {
+        close_conn(c); // idle connection closed by the server
+      } else if (op->parser.eof() == ResponseParser::Status::Done) {
+        finish(c);
+      } else if (c->reused && !op->parser.started() && !op->retried) {
+        // The server dropped a kept-alive connection before we reused it;
+        // nothing of the request was answered, so resend it on a new one.
+        op->retried = true;
+        c->op = nullptr;
+        close_conn(c);
+        touch(op);
+        connect(op);
+      } else {
+        fail(c, httplib::Error::Read);
+      }
+      return;
+    }
+
+    BIO_write(c->rbio, c->in, res);
+    if (c->state == Conn::State::Handshaking) {
+      handshake(c);
+      return;
+    }
+    if (!op) {
+      on_idle_data(c);
+      return;
+    }
+    touch(op);
+
+    char buf[kRecvBuffer];
+    for (;;) {
+      int n = SSL_read(c->ssl, buf, sizeof(buf));
+      if (n <= 0) {
+        int err = SSL_get_error(c->ssl, n);
+        if (err == SSL_ERROR_WANT_READ)
+          break;
+        ERR_clear_error();
+        if (err == SSL_ERROR_ZERO_RETURN &&
+            op->parser.eof() == ResponseParser::Status::Done)
+          finish(c);
+        else
+          fail(c, httplib::Error::Read);
+        return;
+      }
+      switch (op->parser.feed(buf, static_cast<size_t>(n))) {
+      case ResponseParser::Status::More:
+        continue;
+      case ResponseParser::Status::Done:
+        finish(c);
+        return;
+      case ResponseParser::Status::Invalid:
+        fail(c, httplib::Error::Read);
+        return;
+      case ResponseParser::Status::Canceled:
+        fail(c, httplib::Error::Canceled);
+        return;
+      }
+    }
+    // OpenSSL may owe the server something (e.g. a key update reply).
+    if (!flush(c) || !arm_recv(c))
+      fail(c, httplib::Error::Read);
+  }
+
+  // Records on a kept-alive connection between requests. TLS 1.3 servers
+  // send session tickets and key updates at any time; OpenSSL handles those
+  // inside SSL_read, which then wants more input. Application data or a
+  // close_notify ends the connection.
+  void on_idle_data(Conn *c) {
+    char byte;
+    int n = SSL_read(c->ssl, &byte, 1);
+    if (n <= 0 && SSL_get_error(c->ssl, n) == SSL_ERROR_WANT_READ) {
+      if (!flush(c) || !arm_recv(c))
+        close_conn(c);
+      return;
+    }
+    ERR_clear_error();
+    close_conn(c);
+  }
+
+  void finish(Conn *c) {
+    Op *op = c->op;
+    c->op = nullptr;
+    bool reusable = op->parser.keep_alive() && c->state == Conn::State::Ready;
+    complete(op, op->parser.take(), httplib::Error::Success);
+    // The pending recv notices the server closing it while idle.
+    if (reusable && arm_recv(c))
+      idle.push_back(c);
+    else
+      close_conn(c);
+    drain_waiting();
+  }
+
+  void fail(Conn *c, httplib::Error err) {
+    Op *op = c->op;
+    c->op = nullptr;
+    close_conn(c);
+    if (op)
+      complete(op, nullptr, err);
+    drain_waiting();
+  }
+
+  void complete(Op *op, std::unique_ptr<httplib::Response> res,
+                httplib::Error err) {
+    op->done.set_value(httplib::Result(std::move(res), err));
+    delete op;
+  }
+
+  // Takes the connection out of service. It is freed once the kernel has
+  // returned every submission that still references it.
+  void close_conn(Conn *c) {
+    live.erase(c);
+    idle.erase(std::remove(idle.begin(), idle.end(), c), idle.end());
+    if (!c->busy()) {
+      destroy(c);
+      return;
+    }
+    c->closing = true;
+    closing.insert(c);
+    // Ends pending sends and receives even if a cancel can't be queued.
+    ::shutdown(c->fd, SHUT_RDWR);
+    for (Tag t : {kConnect, kSend, kRecv}) {
+      bool pending = t == kConnect ? c->connect_pending
+                     : t == kSend  ? c->send_pending
+                                   : c->recv_pending;
+      if (!pending)
+        continue;
+      if (auto *s = sqe()) {
+        io_uring_prep_cancel64(s, tag(c, t), 0);
+        io_uring_sqe_set_data64(s, kIgnore);
+      }
+    }
+  }
+
+  static void destroy(Conn *c) {
+    if (c->ssl)
+      SSL_free(c->ssl); // frees both BIOs
+    if (c->fd >= 0)
+      ::close(c->fd);
+    delete c;
+  }
+};
+
+UringTransport::UringTransport(const std::string &host, int port)
+    : UringTransport(host, port, Options()) {}
+
+UringTransport::UringTransport(const std::string &host, int port,
+                               Options options)
+    : impl_(std::make_unique<Impl>()) {
+  impl_->host = host;
+  impl_->port = port;
+  impl_->host_header = port == 443 ? host : host + ":" + std::to_string(port);
+  impl_->options = options;
+  if (impl_->options.max_connections == 0)
+    impl_->options.max_connections = 1;
+
+  impl_->tls = std::move(impl_->options.tls);
+  if (impl_->tls)
+    impl_->ctx = impl_->tls->ssl_ctx();
+  impl_->wake_fd = ::eventfd(0, EFD_CLOEXEC);
+  impl_->ring_ok =
+      io_uring_queue_init(options.queue_depth, &impl_->ring, 0) == 0;
+  if (impl_->valid())
+    impl_->loop = std::thread([impl = impl_.get()] { impl->run(); });
+}
+
+UringTransport::~UringTransport() {
+  if (impl_->loop.joinable()) {
+    {
+      std::lock_guard<std::mutex> l(impl_->mutex);
+      impl_->stop = true;
+    }
+    uint64_t one = 1;
+    (void)::write(impl_->wake_fd, &one, sizeof(one));
+    impl_->loop.join();
+  }
+  if (impl_->ring_ok)
+    io_uring_queue_exit(&impl_->ring);
+  for (Conn *c : impl_->live)
+    Impl::destroy(c);
+  for (Conn *c : impl_->closing)
+    Impl::destroy(c);
+  if (impl_->wake_fd >= 0)
+    ::close(impl_->wake_fd);
+}
+
+bool UringTransport::is_valid() const { return impl_->valid(); }
+
+httplib::Result UringTransport::get(const std::string &path,
+                                    const httplib::Params &params,
+                                    const httplib::Headers &headers,
+                                    httplib::ResponseHandler on_response,
+                                    httplib::ContentReceiver on_data) {
+  if (!impl_->valid() || !impl_->resolve())
+    return httplib::Result(nullptr, httplib::Error::Connection);
+
+  auto *op = new Op(std::move(on_response), std::move(on_data));
+  if (auto *hook = connection_hook())
+    op->on_connection = *hook;
+  std::string &req = op->request;
+  req = "GET " + path;
+  char sep = path.find('?') == std::string::npos ? '?' : '&';
+  for (const auto &[k, v] : params) {
+    req += sep + url_encode(k) + "=" + url_encode(v);
+    sep = '&';
+  }
+  req += " HTTP/1.1\r\nHost: " + impl_->host_header + "\r\n";
+  for (const auto &[k, v] : headers)
+    req += k + ": " + v + "\r\n";
+  req += "\r\n";
+
+  auto result = op->done.get_future();
+  {
+    std::lock_guard<std::mutex> l(impl_->mutex);
+    if (impl_->stop) {
+      delete op;
+      return httplib::Result(nullptr, httplib::Error::Canceled);
+    }
+    impl_->incoming.push_back(op);
+  }
+  uint64_t one = 1;
+  (void)::write(impl_->wake_fd, &one, sizeof(one));
+  return result.get();
+}
+
+void UringTransport::set_timeout(std::chrono::seconds timeout) {
+  impl_->timeout_seconds = timeout.count();
+}
+
+void UringTransport::cancel_all() {
+  if (!impl_->valid())
+    return;
+  {
+    std::lock_guard<std::mutex> l(impl_->mutex);
+    impl_->cancel = true;
+  }
+  uint64_t one = 1;
+  (void)::write(impl_->wake_fd, &one, sizeof(one));
+}
+
+} // namespace nexusmods